@@ -3,7 +3,9 @@
 
 #include "ai.hpp"
 #include "engine/chessboard.hpp"
+#include "engine/magic.hpp"
 #include "engine/search.hpp"
+#include "engine/transposition.hpp"
 #include "engine/util.hpp"
 #include <sstream>
 #include <stdlib.h>
@@ -99,9 +101,33 @@ std::string AI::get_name() const
 /// </summary>
 void AI::start()
 {
-    srand(time(NULL));
-    this->history = {};
-    history.reserve(1000);
+    this->key_history = {};
+    this->key_history.reserve(1000);
+
+    // Transposition table size in MB, e.g. --aiSettings "hash=256"
+    std::string hash_megabytes = this->get_setting("hash");
+    if (!hash_megabytes.empty())
+        TT.resize(atoi(hash_megabytes.c_str()));
+
+    // Number of search threads, e.g. --aiSettings "threads=16"
+    std::string threads = this->get_setting("threads");
+    this->search_options.threads = threads.empty() ? 1 : std::max(1, atoi(threads.c_str()));
+
+    // How the threads split the work, "lazy" (default) or "ybwc", e.g. --aiSettings "threads=16&smp=ybwc"
+    this->search_options.mode = (this->get_setting("smp") == "ybwc") ? YBWC_MODE : LAZY_SMP_MODE;
+
+    // Half width of the root's aspiration windows in pawns (0 for none), e.g. --aiSettings "aspiration=2"
+    std::string aspiration = this->get_setting("aspiration");
+    if (!aspiration.empty())
+        this->search_options.aspiration_width = std::max(0, atoi(aspiration.c_str()));
+
+    // Pondering is on unless turned off with --aiSettings "ponder=false"
+    this->ponder_enabled = this->get_setting("ponder") != "false";
+    this->pondering = false;
+
+    // Make sure the magic slider lookups agree with the ray fills before playing
+    if (!verify_magic_attacks(100))
+        print("WARNING: magic bitboard attacks do not match the ray fill attacks");
 }
 
 /// <summary>
@@ -110,6 +136,17 @@ void AI::start()
 void AI::game_updated()
 {
     // If a function you call triggers an update this will be called before it returns.
+    if (!this->pondering)
+        return;
+
+    U64 key = ChessBoard(this->game->fen).key;
+
+    if (key != this->ponder_base_key && key != this->ponder_key) {
+        // Ponder miss: the opponent played something else, so free the CPU
+        // The table keeps whatever the ponder search found
+        print("Ponder miss");
+        this->stop_pondering();
+    }
 }
 
 /// <summary>
@@ -120,6 +157,7 @@ void AI::game_updated()
 void AI::ended(bool won, const std::string &reason)
 {
     // You can do any cleanup of your AI here.  The program ends when this function returns.
+    this->stop_pondering();
 }
 
 /// <summary>
@@ -180,20 +218,101 @@ std::string AI::make_move()
      * 
      *******************************************************************************************************/
     
-    // Parse and save the enemy's last move (if it exists)
-    if (this->history.size()) {
-        this->history.push_back(server_san_to_move(this->game->history.back()));
+    double move_start = GET_TIME_NS();
+    double time_remaining = this->player->time_remaining;
+    ChessBoard board(this->game->fen);
+    int move = 0;
+
+    this->clock.start_move(time_remaining);
+
+    if (this->pondering && board.key == this->ponder_key) {
+        // Ponder hit: the ponder search is already on this position, so let it finish
+        // with the usual allocation counted from when it started pondering
+        print("Ponder hit");
+        this->time_manager.init(time_remaining, this->clock.increment_ns, this->clock.overhead_ns(), board, this->ponder_start);
+        this->ponder_limits.end_time = this->time_manager.hard_deadline();
+        this->ponder_limits.time_manager = &this->time_manager;
+        search_pondering.store(false, std::memory_order_release);
+
+        this->ponder_thread.join();
+        this->pondering = false;
+        move = this->ponder_move;
     }
-    
-    int move = time_limited_iterative_deepening_depth_limited_minimax_alpha_beta_pruning_quiescence_search_history_table(this->game->fen, (this->player->color[0] == 'w') ? WHITE : BLACK, this->history, this->player->time_remaining);
+    else {
+        this->stop_pondering();
+    }
+
+    if (!move)
+        move = time_limited_iterative_deepening_depth_limited_minimax_alpha_beta_pruning_quiescence_search_history_table(this->game->fen, (this->player->color[0] == 'w') ? WHITE : BLACK, this->key_history, time_remaining, this->search_options, this->clock.increment_ns, this->clock.overhead_ns());
     
     std::string move_str = get_move_str(move);
 
+    // Remember this position & the one our move leads to for repetition detection
+    // The opponent's positions are picked up from the FEN on our next turn
+    this->key_history.push_back(board.key);
+    this->key_history.push_back(board.apply_move(move).key);
+
+    this->clock.end_move(time_remaining, GET_TIME_NS() - move_start);
+
+    if (this->ponder_enabled)
+        this->start_pondering(board.apply_move(move));
+
     return move_str;
 }
 
 // You can add additional methods here for your AI to call
 
+// Starts searching the position after the opponent's expected reply to our move, which led to board
+void AI::start_pondering(ChessBoard board)
+{
+    TTEntry entry;
+    MoveList replies;
+    board.actions(replies);
+
+    // The expected reply is the search's best move for the opponent
+    if (!TT.probe(board.key, entry) || std::find(replies.begin(), replies.end(), entry.move) == replies.end())
+        return;
+
+    ChessBoard ponder_board = board.apply_move(entry.move);
+    MoveList actions;
+    ponder_board.actions(actions);
+
+    if (actions.empty())
+        // The reply ends the game
+        return;
+
+    print("Pondering on " + get_move_str(entry.move));
+
+    this->ponder_key_history = this->key_history;
+    this->ponder_base_key = board.key;
+    this->ponder_key = ponder_board.key;
+    this->ponder_limits = this->search_options;
+    this->ponder_move = 0;
+    this->ponder_start = GET_TIME_NS();
+
+    search_stopped = false;
+    search_pondering = true;
+    this->pondering = true;
+
+    bool max_player_color = ponder_board.color;
+    this->ponder_thread = std::thread([this, ponder_board, max_player_color]() {
+        this->ponder_move = smp_search(ponder_board, max_player_color, this->ponder_key_history, this->ponder_limits);
+    });
+}
+
+// Abandons the ponder search, if any
+void AI::stop_pondering(void)
+{
+    if (!this->pondering)
+        return;
+
+    search_stopped = true;
+    this->ponder_thread.join();
+
+    this->pondering = false;
+    search_pondering = false;
+}
+
 } // namespace chess
 
 } // namespace cpp_client
@@ -10,6 +10,11 @@
 #include "../../joueur/src/attr_wrapper.hpp"
 
 // You can add additional #includes here
+#include "engine/chessboard.hpp"
+#include "engine/constants.hpp"
+#include "engine/search.hpp"
+#include <thread>
+#include <vector>
 
 namespace cpp_client
 {
@@ -34,8 +39,23 @@ public:
     Player player;
 
     // You can add additional class variables here.
-    std::vector<int> history;
+    std::vector<U64> key_history; // Zobrist keys of every position before the current one
     int depth_limit;
+    SearchLimits search_options;        // Threads, mode & tuning from --aiSettings, every search starts from these
+
+    ClockMonitor clock;                 // Measures the overhead & increment the server doesn't tell us
+    TimeManager time_manager;           // Plans a promoted ponder search
+
+    // Pondering searches the position after the opponent's expected reply on their clock
+    bool ponder_enabled;
+    bool pondering;                     // ponder_thread is running (or finished but not joined)
+    std::thread ponder_thread;
+    SearchLimits ponder_limits;
+    std::vector<U64> ponder_key_history;
+    U64 ponder_base_key;                // Key after our move
+    U64 ponder_key;                     // Key after the expected reply
+    double ponder_start;
+    int ponder_move;                    // The ponder search's action
 
 
     /// <summary>
@@ -69,6 +89,8 @@ public:
     std::string make_move();
 
     // You can add additional methods here.
+    void start_pondering(ChessBoard board);
+    void stop_pondering(void);
 
 
 
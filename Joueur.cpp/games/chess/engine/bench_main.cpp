@@ -0,0 +1,127 @@
+// Parallel search time-to-depth benchmark
+//
+// Usage:
+//   bench [options] [threads...]   search every bench position to a fixed depth with each
+//                                  thread count (1 2 4 8 16 by default) and report the
+//                                  time taken & nodes searched relative to one thread,
+//                                  along with the null move cutoff rate
+//
+// Options:
+//   -d <depth>     depth to complete (6 by default)
+//   -H <mb>        transposition table size (cleared before every search)
+//   -y             split the tree with YBWC instead of running Lazy SMP
+//   -a <width>     aspiration window half width (0 for full windows)
+
+#include "chessboard.hpp"
+#include "magic.hpp"
+#include "search.hpp"
+#include "transposition.hpp"
+#include "util.hpp"
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+const std::vector<std::string> BENCH_POSITIONS = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+};
+
+int main(int argc, char *argv[]) {
+    if (!verify_magic_attacks(1000)) {
+        std::cerr << "Magic bitboard attacks don't match ray attacks" << std::endl;
+        return 1;
+    }
+
+    SearchLimits limits;
+    limits.depth = 6;
+    limits.silent = true;
+    std::vector<int> thread_counts;
+    int arg = 1;
+
+    for (; arg < argc; arg++) {
+        std::string flag = argv[arg];
+
+        if (flag == "-d" && arg + 1 < argc) {
+            limits.depth = std::max(1, atoi(argv[++arg]));
+        }
+        else if (flag == "-a" && arg + 1 < argc) {
+            limits.aspiration_width = std::max(0, atoi(argv[++arg]));
+        }
+        else if (flag == "-y") {
+            limits.mode = YBWC_MODE;
+        }
+        else if (flag == "-H" && arg + 1 < argc) {
+            TT.resize(std::max(1, atoi(argv[++arg])));
+        }
+        else if (flag[0] != '-') {
+            thread_counts.push_back(std::max(1, atoi(argv[arg])));
+        }
+        else {
+            std::cerr << "usage: " << argv[0] << " [-d depth] [-H mb] [-y] [-a width] [threads...]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (thread_counts.empty())
+        thread_counts = {1, 2, 4, 8, 16};
+
+    double base_time = 0;
+    U64 base_nodes = 0;
+    std::cout << ((limits.mode == YBWC_MODE) ? "YBWC" : "Lazy SMP") << ", depth " << limits.depth << ", "
+              << BENCH_POSITIONS.size() << " positions" << std::endl;
+
+    for (int threads : thread_counts) {
+        SearchStats stats;
+        U64 nodes = 0;
+        U64 steals = 0;
+        U64 researches = 0;
+        U64 null_moves = 0;
+        U64 null_cutoffs = 0;
+        double idle_ns = 0;
+        double elapsed = 0;
+        limits.threads = threads;
+
+        for (auto &fen : BENCH_POSITIONS) {
+            TT.clear();
+
+            ChessBoard board(fen);
+            double start = GET_TIME_NS();
+            search_stopped = false;
+            smp_search(board, board.color, {}, limits, &stats);
+            elapsed += GET_TIME_NS() - start;
+            nodes += stats.nodes;
+            steals += stats.steals;
+            researches += stats.researches;
+            null_moves += stats.null_moves;
+            null_cutoffs += stats.null_cutoffs;
+            idle_ns += stats.idle_ns;
+        }
+
+        if (!base_time) {
+            // The first thread count is the baseline, on one thread both modes search exactly like the serial search
+            base_time = elapsed;
+            base_nodes = nodes;
+        }
+
+        std::cout << std::setw(3) << threads << " threads: "
+                  << std::fixed << std::setprecision(3) << elapsed / 1e9 << " s, "
+                  << std::setprecision(2) << base_time / elapsed << "x time-to-depth, "
+                  << nodes << " nodes, " << (U64)(nodes / (elapsed / 1e9)) << " nps, "
+                  << std::showpos << 100.0 * nodes / base_nodes - 100 << std::noshowpos << "% nodes, "
+                  << researches << " re-searches, "
+                  << std::setprecision(1) << 100.0 * null_cutoffs / std::max<U64>(null_moves, 1) << "% of "
+                  << null_moves << " null moves cut off";
+
+        if (limits.mode == YBWC_MODE)
+            std::cout << ", " << steals << " steals, " << std::setprecision(3) << idle_ns / 1e9 << " s idle";
+
+        std::cout << std::endl;
+    }
+
+    return 0;
+}
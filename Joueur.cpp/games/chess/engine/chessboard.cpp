@@ -3,8 +3,9 @@
 // Unpacks & interprets the given FEN string
 ChessBoard::ChessBoard(std::string fen) {
     // Initialize the bitboards with 12 empty 64b integers
-    this->bitboards = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    this->bitboards.fill(0);
     this->stalemate = false;
+    this->in_check = false;
 
     if (fen != "") {
         // Parse the given FEN string
@@ -87,13 +88,19 @@ ChessBoard::ChessBoard(std::string fen) {
         } // for loop through FEN piece placements
 
         // Castling
-        this->white_can_castle_kingside = str_contains(split_fen[CASTLING], WHITE_CASTLE_KINGSIDE_FEN);
-        this->white_can_castle_queenside = str_contains(split_fen[CASTLING], WHITE_CASTLE_QUEENSIDE_FEN);
-        this->black_can_castle_kingside = str_contains(split_fen[CASTLING], BLACK_CASTLE_KINGSIDE_FEN);
-        this->black_can_castle_queenside = str_contains(split_fen[CASTLING], BLACK_CASTLE_QUEENSIDE_FEN);
+        this->castling_rights = 0;
+        if (str_contains(split_fen[CASTLING], WHITE_CASTLE_KINGSIDE_FEN))
+            this->castling_rights |= WHITE_CASTLE_KINGSIDE_RIGHT;
+        if (str_contains(split_fen[CASTLING], WHITE_CASTLE_QUEENSIDE_FEN))
+            this->castling_rights |= WHITE_CASTLE_QUEENSIDE_RIGHT;
+        if (str_contains(split_fen[CASTLING], BLACK_CASTLE_KINGSIDE_FEN))
+            this->castling_rights |= BLACK_CASTLE_KINGSIDE_RIGHT;
+        if (str_contains(split_fen[CASTLING], BLACK_CASTLE_QUEENSIDE_FEN))
+            this->castling_rights |= BLACK_CASTLE_QUEENSIDE_RIGHT;
 
         // En passant
-        this->en_passant_str = split_fen[EN_PASSANT];
+        // The square is only kept if a pawn can capture there, matching make_move()
+        this->en_passant_square = file_rank_to_square(split_fen[EN_PASSANT]);
 
         // Half moves & whole moves
         this->half_moves = stoi(split_fen[HALF_MOVES]);
@@ -101,16 +108,17 @@ ChessBoard::ChessBoard(std::string fen) {
         
         // Active color
         this->color = (split_fen[ACTIVE_COLOR] == "w") ? WHITE : BLACK;
+
+        if (this->en_passant_square != NO_EN_PASSANT_SQUARE &&
+            !(PAWN_ATTACKS[!this->color][this->en_passant_square] & this->bitboards[(this->color == WHITE) ? WP : BP]))
+            this->en_passant_square = NO_EN_PASSANT_SQUARE;
     } else {
         // No fen was provided, use default values
         // Castling
-        this->white_can_castle_kingside = false;
-        this->white_can_castle_queenside = false;
-        this->black_can_castle_kingside = false;
-        this->black_can_castle_queenside = false;
+        this->castling_rights = 0;
 
         // En passant
-        this->en_passant_str = NO_EN_PASSANT_STR;
+        this->en_passant_square = NO_EN_PASSANT_SQUARE;
 
         // Half moves & whole moves
         this->half_moves = 0;
@@ -119,278 +127,400 @@ ChessBoard::ChessBoard(std::string fen) {
         // Active color
         this->color = 0;
     }
+
+    this->update_occupancy();
+    this->key = this->compute_key();
 }
 
-// Returns a list of all valid moves (SAN strings) for pieces of given color on the board
-void ChessBoard::actions(std::vector<int> &moves) {
-    bool enemy_color = this->get_enemy_color(this->color);
-    std::vector<PieceMoves> enemy_piecemoves;
-    enemy_piecemoves.reserve(MAX_NUM_MOVES); 
-    this->get_moves_for_color(enemy_piecemoves, enemy_color, true);
-
-    // Determine if our king is in check and if so, what moves put it in check
-    U64 king = (this->color == WHITE) ? this->bitboards[WK] : this->bitboards[BK];
-    std::vector<PieceMoves> moves_attacking_king;
-    moves_attacking_king.reserve(10);
-    std::set<U64> pieces_attacking_king;
-    U64 all_enemy_moves = 0;
-    PieceMoves new_piecemoves = PieceMoves(0, 0, 0);
-    this->in_check = false;
+// Recomputes the per-color occupancy bitboards from the piece bitboards
+void ChessBoard::update_occupancy(void) {
+    this->occupancy[WHITE] = this->bitboards[WK] | this->bitboards[WQ] | this->bitboards[WR] |
+                             this->bitboards[WB] | this->bitboards[WN] | this->bitboards[WP];
+    this->occupancy[BLACK] = this->bitboards[BK] | this->bitboards[BQ] | this->bitboards[BR] |
+                             this->bitboards[BB] | this->bitboards[BN] | this->bitboards[BP];
+}
 
-    for (int p = 0; p < enemy_piecemoves.size(); p++) {
-        if (enemy_piecemoves[p].moves & king) {
-            // The king is in check
-            this->in_check = true;
+// Returns every piece of either color attacking square given the occupied squares
+U64 ChessBoard::attackers_to(int square, U64 occupied) const {
+    return (PAWN_ATTACKS[WHITE][square] & this->bitboards[BP]) |
+           (PAWN_ATTACKS[BLACK][square] & this->bitboards[WP]) |
+           (KNIGHT_MOVES[square] & (this->bitboards[WN] | this->bitboards[BN])) |
+           (KING_MOVES[square] & (this->bitboards[WK] | this->bitboards[BK])) |
+           (rook_attacks(square, occupied) & (this->bitboards[WR] | this->bitboards[BR] | this->bitboards[WQ] | this->bitboards[BQ])) |
+           (bishop_attacks(square, occupied) & (this->bitboards[WB] | this->bitboards[BB] | this->bitboards[WQ] | this->bitboards[BQ]));
+}
 
-            // Find which moves attack the king for this piece
-            U64 killshot_moves = this->get_king_killshots(king, enemy_piecemoves[p]);
-            new_piecemoves = PieceMoves(enemy_piecemoves[p].move_type, enemy_piecemoves[p].piece, killshot_moves);
-            moves_attacking_king.emplace_back(new_piecemoves);
-            pieces_attacking_king.insert(new_piecemoves.piece);
-        }
+// Returns the white bitboard index of the piece promotion move promotes to
+static int promoted_piece(int move) {
+    if ((move & PROMO_MOVE_MASK) == QUEEN_PROMO_MOVE_MASK)
+        return WQ;
+    else if ((move & PROMO_MOVE_MASK) == ROOK_PROMO_MOVE_MASK)
+        return WR;
+    else if ((move & PROMO_MOVE_MASK) == BISHOP_PROMO_MOVE_MASK)
+        return WB;
+    else // (move & PROMO_MOVE_MASK) == KNIGHT_PROMO_MOVE_MASK
+        return WN;
+}
+
+// Returns the SEE_VALUES material move wins outright: the piece it captures plus what
+// a promotion gains over the pawn, 0 for other moves
+int ChessBoard::capture_gain(int move) const {
+    int gain = 0;
+
+    if (move & CASTLE_MOVE_MASK)
+        return 0;
+
+    if (move & ATTACK_MOVE_MASK) {
+        U64 to = FILE_RANK_MOVE_MASK_TO_PIECE__TO[(move & TO_FILE_RANK_MOVE_MASK) >> TO_MOVE_SHIFT];
+        int captured = this->get_piece_on(to, !this->color);
 
-        // Add these moves to the enemy's possible moves
-        all_enemy_moves |= enemy_piecemoves[p].moves;
+        // Nothing on the square of a capture means en passant
+        gain = (captured != -1) ? SEE_VALUES[captured] : SEE_VALUES[WP];
     }
 
-    // Get moves for our color
-    std::vector<PieceMoves> piecemoves;
-    piecemoves.reserve(MAX_NUM_MOVES);
-    this->get_moves_for_color(piecemoves, this->color);
+    if (move & PROMO_MOVE_MASK)
+        gain += SEE_VALUES[promoted_piece(move)] - SEE_VALUES[WP];
 
-    // Find where the king piecemove is stored
-    int king_index = this->get_king_index_from_piecemoves_list(piecemoves);
+    return gain;
+}
 
-    // Don't allow friendly king to move into attacked squares
-    piecemoves[king_index].moves &= ~all_enemy_moves;
+// Static exchange evaluation: returns the SEE_VALUES material the side to move gains by
+// making move and then both sides recapturing on its square with their least valuable
+// piece for as long as that pays. Sliders uncovered behind a capturer (x-rays) join in,
+// pins and checks are ignored
+int ChessBoard::see(int move) const {
+    if (move & CASTLE_MOVE_MASK)
+        return 0;
 
-    // Find pinned pieces (pieces that expose the king if moved)
-    std::unordered_map<U64, U64> pinned_pieces_to_pinners;
-    U64 pinner;
-    for (int p = 0; p < piecemoves.size(); p++) {
-        pinner = get_pinner(king, piecemoves[p].piece, enemy_piecemoves);
-        if (pinner)
-            pinned_pieces_to_pinners[piecemoves[p].piece] = pinner;
-    }
+    int to_square = get_to_square(move, this->color);
+    U64 from = FILE_RANK_MOVE_MASK_TO_PIECE__FROM[(move & FROM_FILE_RANK_MOVE_MASK) >> FROM_MOVE_SHIFT];
+    U64 occupied = this->get_all() ^ from;
+    U64 diagonal = this->bitboards[WB] | this->bitboards[BB] | this->bitboards[WQ] | this->bitboards[BQ];
+    U64 straight = this->bitboards[WR] | this->bitboards[BR] | this->bitboards[WQ] | this->bitboards[BQ];
+    int gain[BITBOARD_SIZE / 2 + 1]; // A capture by each piece that can take part, at most 32
+    int depth = 0;
+    bool side = this->color;
 
-    std::vector<int> castling_moves;
-    castling_moves.reserve(2);
-    std::vector<PieceMoves> valid_piecemoves;
-    valid_piecemoves.reserve(MAX_NUM_MOVES);
-    U64 canceling_moves;
-    if (this->in_check) {
-        // The king is in check, get out of check
-        // Make sure the king doesn't move into the path of a sliding piece
-        piecemoves[king_index].moves = this->remove_sliding_path_moves(king, piecemoves[king_index].moves, enemy_piecemoves);
-
-        // Initialize the valid moves with moves for the king
-        valid_piecemoves.emplace_back(piecemoves[king_index]);
-
-        for (int p = 0; p < piecemoves.size(); p++) {
-            // Get moves that cancel out enemy moves attacking the king
-            canceling_moves = this->get_canceling_moves(piecemoves[p], moves_attacking_king);
-
-            if (canceling_moves) {
-                // These moves cancel the attacking moves
-                // Add them to the moves to return
-                piecemoves[p].moves = canceling_moves;
-                valid_piecemoves.emplace_back(piecemoves[p]);
-
-                // This piece isn't pinned if it can get the king out of check
-                if (map_contains(pinned_pieces_to_pinners, piecemoves[p].piece) && set_contains(pieces_attacking_king, pinned_pieces_to_pinners[piecemoves[p].piece]))
-                    pinned_pieces_to_pinners.erase(pinned_pieces_to_pinners.find(piecemoves[p].piece));
-            }
+    // Value of the piece standing on the square, next in line to be captured
+    int on_square = SEE_VALUES[(move & PROMO_MOVE_MASK) ? promoted_piece(move) : MOVE_MASK_TO_BITBOARD_INDEX[move & PIECE_MOVE_MASK]];
+
+    if ((move & ATTACK_MOVE_MASK) && !(this->get_all() & shift_left(1, to_square)))
+        // En passant takes the pawn off the square behind
+        occupied ^= (this->color == WHITE) ? shift_left(1, to_square + 8) : shift_left(1, to_square - 8);
+
+    gain[0] = this->capture_gain(move);
+    U64 attackers = this->attackers_to(to_square, occupied) & occupied;
+
+    while (true) {
+        side = !side;
+        U64 side_attackers = attackers & this->occupancy[side];
+
+        if (!side_attackers)
+            break;
+
+        // What this side has gained if the exchange ends with it capturing what's on the square
+        depth++;
+        gain[depth] = on_square - gain[depth - 1];
+
+        int offset = (side == WHITE) ? 0 : BLACK_BITBOARD_OFFSET;
+        U64 attacker = 0;
+        int attacker_index = 0;
+
+        for (int i = 0; i < NUM_BITBOARDS / 2 && !attacker; i++) {
+            attacker_index = SEE_ATTACKER_ORDER[i] + offset;
+            attacker = side_attackers & this->bitboards[attacker_index];
+        }
+
+        if (attacker_index == WK + offset && (attackers & this->occupancy[!side] & ~attacker)) {
+            // The king can't capture into a defended square
+            depth--;
+            break;
         }
+
+        occupied ^= attacker & (0 - attacker);
+        on_square = SEE_VALUES[attacker_index];
+
+        // Slide in any x-rays behind the capturer
+        attackers |= (bishop_attacks(to_square, occupied) & diagonal) | (rook_attacks(to_square, occupied) & straight);
+        attackers &= occupied;
     }
-    else {
-        // The king is not in check so check avoidance is not necessary
-        // Address castling
-        U64 rooks = (this->color == WHITE) ? this->bitboards[WR] : this->bitboards[BR];
-        this->get_castling_moves(castling_moves, this->color, all_enemy_moves, king, rooks);
 
-        valid_piecemoves = piecemoves;
+    // Either side can stop recapturing when it would lose by going on
+    while (depth) {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+        depth--;
     }
-    
-    // Get the vector of moves
-    this->get_moves(moves, valid_piecemoves, castling_moves, pinned_pieces_to_pinners);
-    
-    // Mix 'em up
-    std::random_shuffle(moves.begin(), moves.end());
+
+    return gain[0];
 }
 
-// Returns all valid PieceMoves for a given color
-void ChessBoard::get_moves_for_color(std::vector<PieceMoves> &moves_for_color, bool color, bool hypothetical) {
-    U64 friendly_pieces = (color == WHITE) ? this->get_white() : this->get_black();
-    U64 enemy_pieces    = (color == WHITE) ? this->get_black() : this->get_white();
-    U64 all_pieces = this->get_all();
-    std::vector<int> bitboard_indices;
-    bitboard_indices.reserve(6);
-    bitboard_indices = (color == WHITE) ? WHITE_BITBOARD_INDICES : BLACK_BITBOARD_INDICES;
-
-    int bitboard_index;
-    for (int k = 0; k < bitboard_indices.size(); k++) {
-        bitboard_index = bitboard_indices[k];
-
-        std::vector<U64> pieces;
-        pieces.reserve(2);
-        pieces = split_bitboard(this->bitboards[bitboard_index]);
-
-        for (int piece_index = 0; piece_index < pieces.size(); piece_index++) {
-            U64 piece = pieces[piece_index];
-            U64 valid_moves_for_piece = 0;
-
-            // Generate moves for this piece
-            // Handle sliding pieces
-            if (bitboard_index == WR || bitboard_index == BR) {
-                valid_moves_for_piece = get_rook_moves(piece, color, hypothetical);
-                moves_for_color.emplace_back(PieceMoves(ROOK, piece, valid_moves_for_piece));
-            }
-            else if (bitboard_index == WB || bitboard_index == BB) {
-                valid_moves_for_piece = get_bishop_moves(piece, color, hypothetical);
-                moves_for_color.emplace_back(PieceMoves(BISHOP, piece, valid_moves_for_piece));
-            }
-            else if (bitboard_index == WQ || bitboard_index == BQ) {
-                // The queen can make both rook and bishop moves
-                valid_moves_for_piece = get_rook_moves(piece, color, hypothetical) | get_bishop_moves(piece, color, hypothetical);
-                moves_for_color.emplace_back(PieceMoves(QUEEN, piece, valid_moves_for_piece));
-            }
+// Returns the Zobrist key of this board computed from scratch
+U64 ChessBoard::compute_key(void) const {
+    U64 key = ZOBRIST_CASTLING[this->castling_rights];
+    U64 pieces;
 
-            // Handle non-sliding pieces
-            else if (bitboard_index == WK || bitboard_index == BK) {
-                // King moves
-                valid_moves_for_piece |= KING_MOVES[piece];
+    for (int bitboard_index = 0; bitboard_index < NUM_BITBOARDS; bitboard_index++) {
+        pieces = this->bitboards[bitboard_index];
 
-                if (!hypothetical) {
-                    // Mask away moves landing on friendly pieces
-                    valid_moves_for_piece &= ~friendly_pieces;
-                }
+        while (pieces)
+            key ^= ZOBRIST_PIECES[bitboard_index][get_square(pop_lsb(pieces))];
+    }
 
-                moves_for_color.emplace_back(PieceMoves(KING, piece, valid_moves_for_piece));
-            }
-            else if (bitboard_index == WN || bitboard_index == BN) {
-                // Knight moves
-                valid_moves_for_piece |= KNIGHT_MOVES[piece];
+    if (this->en_passant_square != NO_EN_PASSANT_SQUARE)
+        key ^= ZOBRIST_EN_PASSANT_FILE[this->en_passant_square % 8];
 
-                if (!hypothetical) {
-                    valid_moves_for_piece &= ~friendly_pieces;
-                }
+    if (this->color == BLACK)
+        key ^= ZOBRIST_BLACK_TO_MOVE;
 
-                moves_for_color.emplace_back(PieceMoves(KNIGHT, piece, valid_moves_for_piece));
-            }
-            else if (bitboard_index == WP || bitboard_index == BP) {
-                // Pawn moves
-                // Attack moves
-                if (bitboard_index == BP) {
-                    valid_moves_for_piece |= shift_left(piece, 7);
-                    valid_moves_for_piece |= shift_left(piece, 9);
-                }
-                else { // if (bitboard_index == WP)
-                    valid_moves_for_piece |= shift_right(piece, 7);
-                    valid_moves_for_piece |= shift_right(piece, 9);
-                }
+    return key;
+}
 
-                // Clean up moves if necessary
-                if (piece & FILE_A) {
-                    valid_moves_for_piece &= FILE_A | FILE_B;
-                }
-                else if (piece & FILE_H) {
-                    valid_moves_for_piece &= FILE_G | FILE_H;
-                }
+// Fills moves with the legal moves of the GenerationModes mode for the side to move
+// Checkers, the check mask and the pin masks are computed once, so every move
+// emitted is legal without having to be played out first
+void ChessBoard::actions(MoveList &moves, int mode) {
+    bool enemy_color = this->get_enemy_color(this->color);
+    int offset = (this->color == WHITE) ? 0 : BLACK_BITBOARD_OFFSET;
+    int enemy_offset = BLACK_BITBOARD_OFFSET - offset;
+    U64 friendly = this->occupancy[this->color];
+    U64 enemy = this->occupancy[enemy_color];
+    U64 all = friendly | enemy;
+    U64 king = this->bitboards[WK + offset];
+    int king_square = get_square(king);
+    U64 enemy_hv = this->bitboards[WR + enemy_offset] | this->bitboards[WQ + enemy_offset];
+    U64 enemy_diag = this->bitboards[WB + enemy_offset] | this->bitboards[WQ + enemy_offset];
+
+    U64 checkers = this->attackers_to(king_square, all) & enemy;
+    this->in_check = checkers != 0;
+
+    // Tactical moves only aim at enemy pieces (pawn pushes only to promote), quiet moves at everything else
+    U64 mode_mask = (mode == TACTICAL_MOVES) ? enemy : (mode == QUIET_MOVES) ? ~enemy : UNIVERSAL_SET;
+    U64 push_mask = (mode == TACTICAL_MOVES) ? RANK_1 | RANK_8 : (mode == QUIET_MOVES) ? ~(RANK_1 | RANK_8) : UNIVERSAL_SET;
+
+    // King moves
+    // The king is lifted off the board so it can't hide from a slider on the slider's own ray
+    U64 king_moves = KING_MOVES[king_square] & ~friendly & mode_mask;
+    U64 safe_king_moves = 0;
+    U64 to;
+    while (king_moves) {
+        to = pop_lsb(king_moves);
+
+        if (!(this->attackers_to(get_square(to), all ^ king) & enemy))
+            safe_king_moves |= to;
+    }
+    this->add_moves(moves, KING_MOVE_MASK, king_square, safe_king_moves, enemy);
+
+    if (!(checkers & (checkers - 1))) {
+        // Not in double check, so pieces other than the king can move
+        // Moves must capture the checker or block its path
+        U64 check_mask = checkers ? BETWEEN[king_square][get_square(checkers)] | checkers : UNIVERSAL_SET;
+        U64 targets = ~friendly & check_mask & mode_mask;
+
+        // Pins: an enemy slider seen through exactly one friendly piece pins that piece
+        U64 pin_hv = 0;
+        U64 pin_diag = 0;
+        U64 snipers, path;
+        int sniper_square;
+
+        snipers = rook_attacks(king_square, enemy) & enemy_hv;
+        while (snipers) {
+            sniper_square = get_square(pop_lsb(snipers));
+            path = BETWEEN[king_square][sniper_square];
+
+            if (count_set_bits(path & friendly) == 1)
+                pin_hv |= path | shift_left(1, sniper_square);
+        }
 
-                if (!hypothetical) {
-                    valid_moves_for_piece &= ~friendly_pieces;
+        snipers = bishop_attacks(king_square, enemy) & enemy_diag;
+        while (snipers) {
+            sniper_square = get_square(pop_lsb(snipers));
+            path = BETWEEN[king_square][sniper_square];
 
-                    // Generate en passant move if it exists
-                    U64 en_passant_move = valid_moves_for_piece & FILE_RANK_TO_PIECE[this->en_passant_str];
+            if (count_set_bits(path & friendly) == 1)
+                pin_diag |= path | shift_left(1, sniper_square);
+        }
 
-                    // Ensure pawn attack moves collide with an enemy piece
-                    if ((valid_moves_for_piece & enemy_pieces) == 0) {
-                        // No overlap with enemies so no valid moves can be made
-                        valid_moves_for_piece = 0;
-                    }
-                    else {
-                        // There is overlap with enemies
-                        valid_moves_for_piece = valid_moves_for_piece & enemy_pieces;
-                    }
+        U64 pinned = (pin_hv | pin_diag) & friendly;
+        U64 pieces, piece_moves;
+        int from;
 
-                    // Save the en passant move
-                    valid_moves_for_piece |= en_passant_move;
-                }
+        // A pinned piece may only move along the line through its king and itself
+        // Knights can never stay on that line
+        pieces = this->bitboards[WN + offset] & ~pinned;
+        while (pieces) {
+            from = get_square(pop_lsb(pieces));
+            this->add_moves(moves, KNIGHT_MOVE_MASK, from, KNIGHT_MOVES[from] & targets, enemy);
+        }
 
-                moves_for_color.emplace_back(PieceMoves(PAWN_ATTACK, piece, valid_moves_for_piece));
+        // Diagonal moves can't keep a piece on a horizontal/vertical pin and vice versa
+        pieces = (this->bitboards[WB + offset] | this->bitboards[WQ + offset]) & ~pin_hv;
+        while (pieces) {
+            from = get_square(pieces);
+            piece_moves = bishop_attacks(from, all) & targets;
 
-                if (hypothetical) {
-                    // We don't care about standard pawn moves, they can't attack pieces
-                    continue;
-                }
+            if (pop_lsb(pieces) & pin_diag)
+                piece_moves &= LINE[king_square][from];
 
-                // Reset and calculate standard pawn moves
-                valid_moves_for_piece = 0;
+            this->add_moves(moves, (this->bitboards[WQ + offset] & shift_left(1, from)) ? QUEEN_MOVE_MASK : BISHOP_MOVE_MASK,
+                            from, piece_moves, enemy);
+        }
 
-                if (bitboard_index == BP) {
-                    valid_moves_for_piece |= shift_left(piece, 8);
+        pieces = (this->bitboards[WR + offset] | this->bitboards[WQ + offset]) & ~pin_diag;
+        while (pieces) {
+            from = get_square(pieces);
+            piece_moves = rook_attacks(from, all) & targets;
 
-                    // Check if a double move is possible
-                    if (piece & RANK_7 && !(all_pieces & shift_left(piece, 8))) {
-                        valid_moves_for_piece |= shift_left(piece, 16);
-                    }
-                }
-                else { // if (bitboard_index == WP)
-                    valid_moves_for_piece |= shift_right(piece, 8);
+            if (pop_lsb(pieces) & pin_hv)
+                piece_moves &= LINE[king_square][from];
 
-                    // Check if a double move is possible
-                    if (piece & RANK_2 && !(all_pieces & shift_right(piece, 8))) {
-                        valid_moves_for_piece |= shift_right(piece, 16);
-                    }
-                }
+            this->add_moves(moves, (this->bitboards[WQ + offset] & shift_left(1, from)) ? QUEEN_MOVE_MASK : ROOK_MOVE_MASK,
+                            from, piece_moves, enemy);
+        }
 
-                // Clean up moves if necessary
-                if (piece & FILE_A) {
-                    valid_moves_for_piece &= FILE_A | FILE_B;
-                }
-                else if (piece & FILE_H) {
-                    valid_moves_for_piece &= FILE_G | FILE_H;
-                }
+        // Pawns
+        U64 double_push_rank = (this->color == WHITE) ? RANK_2 : RANK_7;
+        U64 pawn, push;
+        pieces = this->bitboards[WP + offset];
+        while (pieces) {
+            from = get_square(pieces);
+            pawn = pop_lsb(pieces);
 
-                if (!hypothetical) {
-                    valid_moves_for_piece &= ~friendly_pieces;
+            push = ((this->color == WHITE) ? shift_right(pawn, 8) : shift_left(pawn, 8)) & ~all;
+            piece_moves = push & push_mask;
 
-                    // These moves cannot be made in attack
-                    valid_moves_for_piece &= ~enemy_pieces;
-                }
+            if (push && (pawn & double_push_rank) && mode != TACTICAL_MOVES)
+                piece_moves |= ((this->color == WHITE) ? shift_right(push, 8) : shift_left(push, 8)) & ~all;
+
+            if (mode != QUIET_MOVES)
+                piece_moves |= PAWN_ATTACKS[this->color][from] & enemy;
+            piece_moves &= check_mask;
+
+            if (pawn & pinned)
+                piece_moves &= LINE[king_square][from];
 
-                moves_for_color.emplace_back(PieceMoves(PAWN, piece, valid_moves_for_piece));
+            this->add_pawn_moves(moves, from, piece_moves, enemy);
+        }
+
+        // En passant
+        // The capture lifts two pawns off one rank, so rather than trusting the pin masks
+        // the king is checked for sliders with both pawns gone and the capturer moved
+        if (this->en_passant_square != NO_EN_PASSANT_SQUARE && mode != QUIET_MOVES) {
+            U64 en_passant = shift_left(1, this->en_passant_square);
+            U64 captured = (this->color == WHITE) ? shift_left(en_passant, 8) : shift_right(en_passant, 8);
+            U64 occupied;
+
+            if (check_mask & (en_passant | captured)) {
+                pieces = PAWN_ATTACKS[enemy_color][this->en_passant_square] & this->bitboards[WP + offset];
+
+                while (pieces) {
+                    from = get_square(pieces);
+                    occupied = (all ^ pop_lsb(pieces) ^ captured) | en_passant;
+
+                    if (!(rook_attacks(king_square, occupied) & enemy_hv) && !(bishop_attacks(king_square, occupied) & enemy_diag))
+                        moves.push(PAWN_MOVE_MASK | ATTACK_MOVE_MASK |
+                                   PIECE_TO_FILE_RANK_MOVE_MASK__FROM[from] | PIECE_TO_FILE_RANK_MOVE_MASK__TO[this->en_passant_square]);
+                }
             }
         }
+
+        // Castling
+        if (!this->in_check && (mode == ALL_MOVES || mode == QUIET_MOVES)) {
+            if (this->can_castle(KINGSIDE_CASTLE_MOVE_MASK))
+                moves.push(KINGSIDE_CASTLE_MOVE_MASK);
+            if (this->can_castle(QUEENSIDE_CASTLE_MOVE_MASK))
+                moves.push(QUEENSIDE_CASTLE_MOVE_MASK);
+        }
     }
+
+    // Running out of tactical or quiet moves alone says nothing about stalemate
+    this->stalemate = moves.empty() && !this->in_check && mode == ALL_MOVES;
 }
 
-// Returns the rook's possible moves as a single bitboard
-U64 ChessBoard::get_rook_moves(U64 rook, bool color, bool hypothetical) {
-    U64 empty = this->get_empty();
+// Sets in_check for the side to move without generating its moves, returning it
+bool ChessBoard::update_in_check(void) {
+    int offset = (this->color == WHITE) ? 0 : BLACK_BITBOARD_OFFSET;
+    U64 checkers = this->attackers_to(get_square(this->bitboards[WK + offset]), this->get_all()) &
+                   this->occupancy[this->get_enemy_color(this->color)];
 
-    U64 rook_moves = e_ray(rook, empty) | w_ray(rook, empty) | n_ray(rook, empty) | s_ray(rook, empty);
+    this->in_check = checkers != 0;
+    return this->in_check;
+}
+
+// Returns true if move is one of the side to move's legal moves, exactly as actions() would emit it
+// For moves remembered from other positions (hash moves, killers...), which can then be searched
+// without generating the list they belong to
+bool ChessBoard::is_legal(int move) const {
+    int offset = (this->color == WHITE) ? 0 : BLACK_BITBOARD_OFFSET;
+    bool enemy_color = this->get_enemy_color(this->color);
+    U64 friendly = this->occupancy[this->color];
+    U64 enemy = this->occupancy[enemy_color];
+    U64 all = friendly | enemy;
 
-    if (!hypothetical) {
-        // Make sure friend-occupied spaces can't be moved to
-        rook_moves &= ~((color == WHITE) ? this->get_white() : this->get_black());
+    if (move & CASTLE_MOVE_MASK) {
+        U64 king = this->bitboards[WK + offset];
+        return !(this->attackers_to(get_square(king), all) & enemy) && this->can_castle(move & CASTLE_MOVE_MASK);
     }
 
-    return rook_moves;
-}
+    int piece = move & PIECE_MOVE_MASK;
+    U64 from = FILE_RANK_MOVE_MASK_TO_PIECE__FROM[(move & FROM_FILE_RANK_MOVE_MASK) >> FROM_MOVE_SHIFT];
+    U64 to = FILE_RANK_MOVE_MASK_TO_PIECE__TO[(move & TO_FILE_RANK_MOVE_MASK) >> TO_MOVE_SHIFT];
+
+    if (piece < KING_MOVE_MASK || piece > PAWN_MOVE_MASK || !from || !to ||
+        !(this->bitboards[MOVE_MASK_TO_BITBOARD_INDEX[piece] + offset] & from) || (to & friendly))
+        return false;
+
+    int from_square = get_square(from);
+    int to_square = get_square(to);
+    bool en_passant = piece == PAWN_MOVE_MASK && to_square == this->en_passant_square;
+
+    // The flags have to match the position
+    if (!(move & ATTACK_MOVE_MASK) != !((to & enemy) || en_passant))
+        return false;
+
+    if (!(move & PROMO_MOVE_MASK) != !(piece == PAWN_MOVE_MASK && (to & (RANK_1 | RANK_8))))
+        return false;
 
-// Returns the bishop's possible moves as a single bitboard
-U64 ChessBoard::get_bishop_moves(U64 bishop, bool color, bool hypothetical) {
-    U64 empty = this->get_empty();
+    U64 reach;
+    switch (piece) {
+    case KING_MOVE_MASK:
+        reach = KING_MOVES[from_square];
+        break;
 
-    U64 bishop_moves = ne_ray(bishop, empty) | nw_ray(bishop, empty) | sw_ray(bishop, empty) | se_ray(bishop, empty);
+    case QUEEN_MOVE_MASK:
+        reach = bishop_attacks(from_square, all) | rook_attacks(from_square, all);
+        break;
 
-    if (!hypothetical) {
-        // Make sure friend-occupied spaces can't be moved to
-        bishop_moves &= ~((color == WHITE) ? this->get_white() : this->get_black());
+    case BISHOP_MOVE_MASK:
+        reach = bishop_attacks(from_square, all);
+        break;
+
+    case ROOK_MOVE_MASK:
+        reach = rook_attacks(from_square, all);
+        break;
+
+    case KNIGHT_MOVE_MASK:
+        reach = KNIGHT_MOVES[from_square];
+        break;
+
+    default: // PAWN_MOVE_MASK
+        if (move & ATTACK_MOVE_MASK) {
+            reach = PAWN_ATTACKS[this->color][from_square];
+        }
+        else {
+            reach = ((this->color == WHITE) ? shift_right(from, 8) : shift_left(from, 8)) & ~all;
+
+            if (reach && (from & ((this->color == WHITE) ? RANK_2 : RANK_7)))
+                reach |= ((this->color == WHITE) ? shift_right(reach, 8) : shift_left(reach, 8)) & ~all;
+        }
     }
 
-    return bishop_moves;
+    if (!(reach & to))
+        return false;
+
+    // Play it out to see whether it leaves the king in check
+    ChessBoard board = this->apply_move(move);
+    U64 king = board.bitboards[WK + offset];
+    return !(board.attackers_to(get_square(king), board.get_all()) & board.occupancy[enemy_color]);
 }
 
 // Returns the bitboard at given bitboard index
@@ -399,515 +529,330 @@ U64 ChessBoard::get_bitboard(int bitboard_index) {
 }
 
 // Returns the enemy's color given the friendly color
-bool ChessBoard::get_enemy_color(bool color) {
+bool ChessBoard::get_enemy_color(bool color) const {
     return (color == WHITE) ? BLACK : WHITE;
 }
 
-U64 ChessBoard::get_white(void) {
-    return this->bitboards[WK] | this->bitboards[WQ] | this->bitboards[WR] |
-           this->bitboards[WB] | this->bitboards[WN] | this->bitboards[WP];
-}
+// Appends a move from square from to each square in targets
+void ChessBoard::add_moves(MoveList &moves, int piece_move_mask, int from, U64 targets, U64 enemy) {
+    int move = piece_move_mask | PIECE_TO_FILE_RANK_MOVE_MASK__FROM[from];
+    U64 to;
 
-U64 ChessBoard::get_black(void) {
-    return this->bitboards[BK] | this->bitboards[BQ] | this->bitboards[BR] |
-           this->bitboards[BB] | this->bitboards[BN] | this->bitboards[BP];
+    while (targets) {
+        to = pop_lsb(targets);
+        moves.push(move | PIECE_TO_FILE_RANK_MOVE_MASK__TO[get_square(to)] | ((to & enemy) ? ATTACK_MOVE_MASK : 0));
+    }
 }
 
-U64 ChessBoard::get_all(void) {
-    return this->get_white() | this->get_black();
-}
+// Appends a pawn move from square from to each square in targets,
+// one per promotion choice when the pawn reaches the last rank
+void ChessBoard::add_pawn_moves(MoveList &moves, int from, U64 targets, U64 enemy) {
+    int move = PAWN_MOVE_MASK | PIECE_TO_FILE_RANK_MOVE_MASK__FROM[from];
+    U64 to;
 
-U64 ChessBoard::get_empty(void) {
-    return ~(this->get_all());
-}
+    while (targets) {
+        to = pop_lsb(targets);
+        int pawn_move = move | PIECE_TO_FILE_RANK_MOVE_MASK__TO[get_square(to)] | ((to & enemy) ? ATTACK_MOVE_MASK : 0);
 
-// Returns a bitboard of moves that attack the king from enemy_piecemoves
-U64 ChessBoard::get_king_killshots(U64 king, PieceMoves enemy_piecemoves) {
-    // First deal with sliding moves
-    if (this->is_sliding_move(enemy_piecemoves.move_type)) {
-        // Check if any ray from enemy collides with the king
-        std::vector<U64> rays;
-        rays.reserve(8);
-        rays = RAYS_LIST[enemy_piecemoves.piece];
-
-        for (int r = 0; r < rays.size(); r++) {
-            if (king & enemy_piecemoves.moves & rays[r]) {
-                // This ray contains an attack on the king
-                return enemy_piecemoves.moves & rays[r];
-            }
+        if (to & (RANK_1 | RANK_8)) {
+            for (int p = 0; p < LEN_PAWN_PROMOTION_CHOICES; p++)
+                moves.push(pawn_move | PAWN_PROMOTION_MOVE_MASK_CHOICES[p]);
+        }
+        else {
+            moves.push(pawn_move);
         }
+    }
+}
 
-        // No killshots from this enemy
-        return 0;
+// Returns true if the side to move may castle (castle_move_mask): the right is held, the king &
+// rook are in place, the squares between them are empty and the king doesn't pass through or
+// land in check. Whether the king is in check already is up to the caller
+bool ChessBoard::can_castle(int castle_move_mask) const {
+    bool kingside = castle_move_mask == KINGSIDE_CASTLE_MOVE_MASK;
+    int right;
+    U64 king_rook, empty_path, king_path;
+
+    if (this->color == WHITE) {
+        right      = kingside ? WHITE_CASTLE_KINGSIDE_RIGHT : WHITE_CASTLE_QUEENSIDE_RIGHT;
+        king_rook  = kingside ? WHITE_CASTLE_KINGSIDE_MASK : WHITE_CASTLE_QUEENSIDE_MASK;
+        empty_path = kingside ? WHITE_CASTLE_KINGSIDE_INVALID : WHITE_CASTLE_QUEENSIDE_INVALID;
+        king_path  = kingside ? WHITE_CASTLE_KINGSIDE_ROOK_MOVE | WHITE_CASTLE_KINGSIDE_KING_MOVE
+                              : WHITE_CASTLE_QUEENSIDE_ROOK_MOVE | WHITE_CASTLE_QUEENSIDE_KING_MOVE;
     }
-    else {
-        // this is a non-sliding piece
-        // Only enemy moves that intersect with the king are killshots
-        return enemy_piecemoves.moves & king;
+    else { // this->color == BLACK
+        right      = kingside ? BLACK_CASTLE_KINGSIDE_RIGHT : BLACK_CASTLE_QUEENSIDE_RIGHT;
+        king_rook  = kingside ? BLACK_CASTLE_KINGSIDE_MASK : BLACK_CASTLE_QUEENSIDE_MASK;
+        empty_path = kingside ? BLACK_CASTLE_KINGSIDE_INVALID : BLACK_CASTLE_QUEENSIDE_INVALID;
+        king_path  = kingside ? BLACK_CASTLE_KINGSIDE_ROOK_MOVE | BLACK_CASTLE_KINGSIDE_KING_MOVE
+                              : BLACK_CASTLE_QUEENSIDE_ROOK_MOVE | BLACK_CASTLE_QUEENSIDE_KING_MOVE;
     }
-}
 
-// Returns true if the move type is sliding, false otherwise
-bool ChessBoard::is_sliding_move(int move_type) {
-    return move_type == QUEEN || move_type == BISHOP || move_type == ROOK;
-}
+    int offset = (this->color == WHITE) ? 0 : BLACK_BITBOARD_OFFSET;
+    U64 king = this->bitboards[WK + offset];
+    U64 all = this->get_all();
+    U64 enemy = this->occupancy[this->get_enemy_color(this->color)];
+
+    if (!(this->castling_rights & right) || !(king_rook & king) || !(king_rook & ~king & this->bitboards[WR + offset]) ||
+        (empty_path & all))
+        return false;
 
-// Returns the index of the king in piecemoves
-int ChessBoard::get_king_index_from_piecemoves_list(std::vector<PieceMoves> piecemoves) {
-    for (int i = 0; i < piecemoves.size(); i++) {
-        if (piecemoves[i].move_type == KING)
-            return i;
+    while (king_path) {
+        if (this->attackers_to(get_square(pop_lsb(king_path)), all) & enemy)
+            return false;
     }
 
-    return -1;
+    return true;
 }
 
-// Returns the enemy that pins piece and zero if no piece is pinned
-// Where a pinned piece cannot move because if it does, it exposes the king to an enemy
-U64 ChessBoard::get_pinner(U64 king, U64 piece, std::vector<PieceMoves> enemy_piecemoves) {
-    if (piece == king)
-        // The king can't be pinned
-        return 0;
+// Returns the castling rights lost when a piece moves from or to square
+static int castling_rights_lost(U64 square) {
+    int lost = 0;
+
+    if (square & WHITE_KING_START)
+        lost |= WHITE_CASTLE_RIGHTS;
+    if (square & WHITE_CASTLE_KINGSIDE_MASK & ~WHITE_KING_START)
+        lost |= WHITE_CASTLE_KINGSIDE_RIGHT;
+    if (square & WHITE_CASTLE_QUEENSIDE_MASK & ~WHITE_KING_START)
+        lost |= WHITE_CASTLE_QUEENSIDE_RIGHT;
+    if (square & BLACK_KING_START)
+        lost |= BLACK_CASTLE_RIGHTS;
+    if (square & BLACK_CASTLE_KINGSIDE_MASK & ~BLACK_KING_START)
+        lost |= BLACK_CASTLE_KINGSIDE_RIGHT;
+    if (square & BLACK_CASTLE_QUEENSIDE_MASK & ~BLACK_KING_START)
+        lost |= BLACK_CASTLE_QUEENSIDE_RIGHT;
+
+    return lost;
+}
 
-    std::set<U64>::iterator ray; 
-    U64 possible_blockers;
-    std::vector<U64> split_possible_blockers;
-    split_possible_blockers.reserve(5);
-    bool pinned;
-    
-    for (int p = 0; p < enemy_piecemoves.size(); p++) {
-        // Only deal with sliding enemies
-        // They are the only piece types that can pin other pieces
-        if (this->is_sliding_move(enemy_piecemoves[p].move_type)) {
-            // Check for the possibility of a pinned piece
-            if (RAYS[enemy_piecemoves[p].piece] & RAYS[king] & piece) {
-                // This piece may be pinned
-                if (enemy_piecemoves[p].move_type == ROOK) {
-                    for (ray = HV_RAYS_SET.begin(); ray != HV_RAYS_SET.end(); ++ray) {
-                        if ((*ray | enemy_piecemoves[p].piece | king | piece) == *ray) {
-                            // These pieces occupy the same ray
-                            possible_blockers = (*ray & ~(enemy_piecemoves[p].piece | king | piece)) & this->get_all();
-                            
-                            if (possible_blockers) {                            
-                                split_possible_blockers = split_bitboard(possible_blockers);
-                                
-                                pinned = true;
-
-                                for (int b = 0; b < split_possible_blockers.size(); b++) {
-                                    // Ensure the order is as expected for pinned pieces
-                                    if (!((split_possible_blockers[b] > king && king > piece && piece > enemy_piecemoves[p].piece) || 
-                                        (split_possible_blockers[b] < king && king < piece && piece < enemy_piecemoves[p].piece) ||
-                                        (king > piece && piece > enemy_piecemoves[p].piece && enemy_piecemoves[p].piece > split_possible_blockers[b]) || 
-                                        (king < piece && piece < enemy_piecemoves[p].piece && enemy_piecemoves[p].piece < split_possible_blockers[b]))) {
-                                        pinned = false;
-                                        break;
-                                    }
-                                }
-
-                                if (pinned)
-                                    // This piece is pinned, return the enemy pinner
-                                    return enemy_piecemoves[p].piece;
-                            } else {
-                                if ((king > piece && piece > enemy_piecemoves[p].piece) || (king < piece && piece < enemy_piecemoves[p].piece)) {
-                                    // This piece is pinned, return the enemy pinner
-                                    return enemy_piecemoves[p].piece;
-                                }
-                            }
-                        }
-                    }
-                } else if (enemy_piecemoves[p].move_type == BISHOP) {
-                    for (ray = DIAG_RAYS_SET.begin(); ray != DIAG_RAYS_SET.end(); ++ray) {
-                        if ((*ray | enemy_piecemoves[p].piece | king | piece) == *ray) {
-                            // These pieces occupy the same ray
-                            possible_blockers = (*ray & ~(enemy_piecemoves[p].piece | king | piece)) & this->get_all();
-                            
-                            if (possible_blockers) {                            
-                                split_possible_blockers = split_bitboard(possible_blockers);
-                                
-                                pinned = true;
-
-                                for (int b = 0; b < split_possible_blockers.size(); b++) {
-                                    // Ensure the order is as expected for pinned pieces
-                                    if (!((split_possible_blockers[b] > king && king > piece && piece > enemy_piecemoves[p].piece) || 
-                                        (split_possible_blockers[b] < king && king < piece && piece < enemy_piecemoves[p].piece) ||
-                                        (king > piece && piece > enemy_piecemoves[p].piece && enemy_piecemoves[p].piece > split_possible_blockers[b]) || 
-                                        (king < piece && piece < enemy_piecemoves[p].piece && enemy_piecemoves[p].piece < split_possible_blockers[b]))) {
-                                        pinned = false;
-                                        break;
-                                    }
-                                }
-
-                                if (pinned)
-                                    // This piece is pinned, return the enemy pinner
-                                    return enemy_piecemoves[p].piece;
-                            } else {
-                                if ((king > piece && piece > enemy_piecemoves[p].piece) || (king < piece && piece < enemy_piecemoves[p].piece)) {
-                                    // This piece is pinned, return the enemy pinner
-                                    return enemy_piecemoves[p].piece;
-                                }
-                            }
-                        }
-                    }
-                } else  { // enemy_piecemoves[p].move_type == QUEEN
-                    for (ray = RAYS_SET.begin(); ray != RAYS_SET.end(); ++ray) {
-                        if ((*ray | enemy_piecemoves[p].piece | king | piece) == *ray) {
-                            // These pieces occupy the same ray
-                            possible_blockers = (*ray & ~(enemy_piecemoves[p].piece | king | piece)) & this->get_all();
-                            
-                            if (possible_blockers) {                            
-                                split_possible_blockers = split_bitboard(possible_blockers);
-                                
-                                pinned = true;
-
-                                for (int b = 0; b < split_possible_blockers.size(); b++) {
-                                    // Ensure the order is as expected for pinned pieces
-                                    if (!((split_possible_blockers[b] > king && king > piece && piece > enemy_piecemoves[p].piece) || 
-                                        (split_possible_blockers[b] < king && king < piece && piece < enemy_piecemoves[p].piece) ||
-                                        (king > piece && piece > enemy_piecemoves[p].piece && enemy_piecemoves[p].piece > split_possible_blockers[b]) || 
-                                        (king < piece && piece < enemy_piecemoves[p].piece && enemy_piecemoves[p].piece < split_possible_blockers[b]))) {
-                                        pinned = false;
-                                        break;
-                                    }
-                                }
-
-                                if (pinned)
-                                    // This piece is pinned, return the enemy pinner
-                                    return enemy_piecemoves[p].piece;
-                            } else {
-                                if ((king > piece && piece > enemy_piecemoves[p].piece) || (king < piece && piece < enemy_piecemoves[p].piece)) {
-                                    // This piece is pinned, return the enemy pinner
-                                    return enemy_piecemoves[p].piece;
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        }
-    }
+// Returns the bitboard index of color's piece on square, -1 if there is none
+int ChessBoard::get_piece_on(U64 square, bool color) const {
+    if (!(this->occupancy[color] & square))
+        return -1;
 
-    return 0;
-}
+    int first = (color == WHITE) ? WK : BK;
 
-// Returns moves for the king that are not in the path of sliding enemy pieces
-U64 ChessBoard::remove_sliding_path_moves(U64 king, U64 king_moves, std::vector<PieceMoves> enemy_piecemoves) {
-    for (int e = 0; e < enemy_piecemoves.size(); e++) {
-        // Only deal with sliding piece moves
-        if (this->is_sliding_move(enemy_piecemoves[e].move_type)) {
-            // Get the rays starting from this piece
-            std::vector<U64> rays;
-            rays.reserve(8);
-            rays = RAYS_LIST[enemy_piecemoves[e].piece];
-
-            for (int r = 0; r < rays.size(); r++) {
-                if (king & enemy_piecemoves[e].moves & rays[r]) {
-                    // The king may attempt to move along this ray. Prevent that
-                    king_moves &= ~rays[r];
-                }
-            }
-        }
+    for (int bitboard_index = first; bitboard_index < first + NUM_BITBOARDS / 2; bitboard_index++) {
+        if (this->bitboards[bitboard_index] & square)
+            return bitboard_index;
     }
 
-    return king_moves;
+    return -1;
 }
 
-// Returns a bitboard of moves that cancel all moves attacking the king (if they exist)
-// 0 is returned otherwise
-U64 ChessBoard::get_canceling_moves(PieceMoves piecemoves, std::vector<PieceMoves> moves_attacking_king) {
-    U64 canceling_moves = 0;
-    U64 local_canceling_moves;
+// Moves a piece between two squares on its bitboard, its color's occupancy and the key
+void ChessBoard::move_piece(int bitboard_index, U64 from, U64 to) {
+    this->bitboards[bitboard_index] ^= from | to;
+    this->occupancy[bitboard_index >= BK] ^= from | to;
+    this->key ^= ZOBRIST_PIECES[bitboard_index][get_square(from)] ^ ZOBRIST_PIECES[bitboard_index][get_square(to)];
+}
 
-    for (int i = 0; i < moves_attacking_king.size(); i++) {
-        local_canceling_moves = 0;
+// Adds or removes a piece on its bitboard, its color's occupancy and the key
+void ChessBoard::toggle_piece(int bitboard_index, U64 square) {
+    this->bitboards[bitboard_index] ^= square;
+    this->occupancy[bitboard_index >= BK] ^= square;
+    this->key ^= ZOBRIST_PIECES[bitboard_index][get_square(square)];
+}
 
-        // Save moves that take out this attacking piece or that block it from moving
-        local_canceling_moves |= (piecemoves.moves & moves_attacking_king[i].piece) |
-                                 (piecemoves.moves & moves_attacking_king[i].moves);
+// Applies move to this board in place, saving what is needed to take it back in undo
+void ChessBoard::make_move(int move, UndoInfo &undo) {
+    int offset = (this->color == WHITE) ? 0 : BLACK_BITBOARD_OFFSET;
+    bool enemy_color = this->get_enemy_color(this->color);
 
-        if (!local_canceling_moves) {
-            // This attacker could not be neutralized
-            return 0;
+    undo.key = this->key;
+    undo.captured = -1;
+    undo.castling_rights = this->castling_rights;
+    undo.en_passant_square = this->en_passant_square;
+    undo.half_moves = this->half_moves;
+
+    // Castling rights & en passant are XORed back in once the move is made
+    this->key ^= ZOBRIST_CASTLING[this->castling_rights];
+    if (this->en_passant_square != NO_EN_PASSANT_SQUARE)
+        this->key ^= ZOBRIST_EN_PASSANT_FILE[this->en_passant_square % 8];
+
+    this->en_passant_square = NO_EN_PASSANT_SQUARE;
+
+    if (move & CASTLE_MOVE_MASK) {
+        bool kingside = (move & CASTLE_MOVE_MASK) == KINGSIDE_CASTLE_MOVE_MASK;
+        U64 king_start = (this->color == WHITE) ? WHITE_KING_START : BLACK_KING_START;
+        U64 king_rook, new_king, new_rook;
+
+        if (this->color == WHITE) {
+            king_rook = kingside ? WHITE_CASTLE_KINGSIDE_MASK : WHITE_CASTLE_QUEENSIDE_MASK;
+            new_king  = kingside ? WHITE_CASTLE_KINGSIDE_KING_MOVE : WHITE_CASTLE_QUEENSIDE_KING_MOVE;
+            new_rook  = kingside ? WHITE_CASTLE_KINGSIDE_ROOK_MOVE : WHITE_CASTLE_QUEENSIDE_ROOK_MOVE;
+        } else { // this->color == BLACK
+            king_rook = kingside ? BLACK_CASTLE_KINGSIDE_MASK : BLACK_CASTLE_QUEENSIDE_MASK;
+            new_king  = kingside ? BLACK_CASTLE_KINGSIDE_KING_MOVE : BLACK_CASTLE_QUEENSIDE_KING_MOVE;
+            new_rook  = kingside ? BLACK_CASTLE_KINGSIDE_ROOK_MOVE : BLACK_CASTLE_QUEENSIDE_ROOK_MOVE;
         }
 
-        canceling_moves |= local_canceling_moves;
-    }
+        this->move_piece(WK + offset, king_start, new_king);
+        this->move_piece(WR + offset, king_rook & ~king_start, new_rook);
+        this->castling_rights &= ~((this->color == WHITE) ? WHITE_CASTLE_RIGHTS : BLACK_CASTLE_RIGHTS);
+        this->half_moves++;
+    } else {
+        U64 from = FILE_RANK_MOVE_MASK_TO_PIECE__FROM[(move & FROM_FILE_RANK_MOVE_MASK) >> FROM_MOVE_SHIFT];
+        U64 to   = FILE_RANK_MOVE_MASK_TO_PIECE__TO[(move & TO_FILE_RANK_MOVE_MASK) >> TO_MOVE_SHIFT];
+        int moving = MOVE_MASK_TO_BITBOARD_INDEX[move & PIECE_MOVE_MASK] + offset;
+        bool pawn_moving = (move & PIECE_MOVE_MASK) == PAWN_MOVE_MASK;
+        U64 captured_square = to;
 
-    return canceling_moves;
-}
+        // A pawn moving diagonally onto the en passant square captures the pawn behind it
+        if (pawn_moving && undo.en_passant_square != NO_EN_PASSANT_SQUARE && to == shift_left(1, undo.en_passant_square))
+            captured_square = (this->color == WHITE) ? shift_left(to, 8) : shift_right(to, 8);
+
+        undo.captured = this->get_piece_on(captured_square, enemy_color);
 
-// Returns a list of possible castling moves for color if they can be made
-void ChessBoard::get_castling_moves(std::vector<int> &castling_moves, bool color, U64 all_enemy_moves, U64 king, U64 rooks) {
-    if (color == WHITE) {
-        if (this->white_can_castle_kingside &&
-            WHITE_CASTLE_KINGSIDE_MASK & king &&
-            WHITE_CASTLE_KINGSIDE_MASK & rooks &&
-            !(WHITE_CASTLE_KINGSIDE_INVALID & this->get_all()) &&
-            !(WHITE_CASTLE_KINGSIDE_INVALID & all_enemy_moves) &&
-            !(WHITE_CASTLE_KINGSIDE_KING_MOVE & all_enemy_moves)) {
-            // White can castle kingside
-            castling_moves.emplace_back(KINGSIDE_CASTLE_MOVE_MASK);
+        if (undo.captured != -1)
+            this->toggle_piece(undo.captured, captured_square);
+
+        if (pawn_moving && (move & PROMO_MOVE_MASK)) {
+            // Swap the pawn out for the promoted piece
+            this->toggle_piece(moving, from);
+            this->toggle_piece(promoted_piece(move) + offset, to);
+        } else {
+            this->move_piece(moving, from, to);
         }
 
-        if (this->white_can_castle_queenside &&
-            WHITE_CASTLE_QUEENSIDE_MASK & king &&
-            WHITE_CASTLE_QUEENSIDE_MASK & rooks &&
-            !(WHITE_CASTLE_QUEENSIDE_INVALID & this->get_all()) &&
-            !(WHITE_CASTLE_QUEENSIDE_INVALID & all_enemy_moves) &&
-            !(WHITE_CASTLE_QUEENSIDE_KING_MOVE & all_enemy_moves)) {
-            // White can castle queenside
-            castling_moves.emplace_back(QUEENSIDE_CASTLE_MOVE_MASK);
+        // A double pawn push leaves the skipped square open to en passant
+        // It is only recorded if an enemy pawn can capture there, so positions that differ only
+        // by an unusable en passant square share a key
+        int skipped = NO_EN_PASSANT_SQUARE;
+        if (pawn_moving && from == shift_left(to, 16))
+            skipped = get_square(shift_left(to, 8));
+        else if (pawn_moving && from == shift_right(to, 16))
+            skipped = get_square(shift_right(to, 8));
+
+        if (skipped != NO_EN_PASSANT_SQUARE && (PAWN_ATTACKS[this->color][skipped] & this->bitboards[WP + BLACK_BITBOARD_OFFSET - offset])) {
+            this->en_passant_square = skipped;
+            this->key ^= ZOBRIST_EN_PASSANT_FILE[skipped % 8];
         }
+
+        this->castling_rights &= ~(castling_rights_lost(from) | castling_rights_lost(to));
+
+        if (pawn_moving || undo.captured != -1)
+            this->half_moves = 0;
+        else
+            this->half_moves++;
     }
-    else { // color == BLACK 
-        if (this->black_can_castle_kingside &&
-            BLACK_CASTLE_KINGSIDE_MASK & king &&
-            BLACK_CASTLE_KINGSIDE_MASK & rooks &&
-            !(BLACK_CASTLE_KINGSIDE_INVALID & this->get_all()) &&
-            !(BLACK_CASTLE_KINGSIDE_INVALID & all_enemy_moves) &&
-            !(BLACK_CASTLE_KINGSIDE_KING_MOVE & all_enemy_moves)) {
-            // Black can castle kingside
-            castling_moves.emplace_back(KINGSIDE_CASTLE_MOVE_MASK);
-        }
 
-        if (this->black_can_castle_queenside &&
-            BLACK_CASTLE_QUEENSIDE_MASK & king &&
-            BLACK_CASTLE_QUEENSIDE_MASK & rooks &&
-            !(BLACK_CASTLE_QUEENSIDE_INVALID & this->get_all()) &&
-            !(BLACK_CASTLE_QUEENSIDE_INVALID & all_enemy_moves) &&
-            !(BLACK_CASTLE_QUEENSIDE_KING_MOVE & all_enemy_moves)) {
-            // Black can castle queenside
-            castling_moves.emplace_back(QUEENSIDE_CASTLE_MOVE_MASK);
-        }
+    this->key ^= ZOBRIST_CASTLING[this->castling_rights] ^ ZOBRIST_BLACK_TO_MOVE;
+
+    if (this->color == BLACK)
+        this->whole_moves++;
+
+    this->color = enemy_color;
+
+#ifdef DEBUG_ZOBRIST
+    if (this->key != this->compute_key()) {
+        std::cerr << "Zobrist key mismatch after " << get_move_str(move) << std::endl;
+        abort();
     }
+#endif
 }
 
-void ChessBoard::get_moves(std::vector<int> &moves, std::vector<PieceMoves> piecemoves, std::vector<int> castling_moves, std::unordered_map<U64, U64> blacklist) {
-    int move, piece_move_mask;
-    U64 enemy_pieces = (this->color == WHITE) ? this->get_black() : this->get_white();
-    std::vector<U64> moves_for_piece;
-    moves_for_piece.reserve(MAX_NUM_MOVES / 3);
+// Takes back move, which must be the last move made with make_move, using the saved undo info
+void ChessBoard::unmake_move(int move, const UndoInfo &undo) {
+    this->color = this->get_enemy_color(this->color);
 
-    for (int p = 0; p < piecemoves.size(); p++) {
-        if (map_contains(blacklist, piecemoves[p].piece)) {
-            // Don't generate moves for blacklisted pieces
-            continue;
-        }
+    if (this->color == BLACK)
+        this->whole_moves--;
+
+    int offset = (this->color == WHITE) ? 0 : BLACK_BITBOARD_OFFSET;
 
-        // Separate out possible moves
-        moves_for_piece = split_bitboard(piecemoves[p].moves);
+    if (move & CASTLE_MOVE_MASK) {
+        bool kingside = (move & CASTLE_MOVE_MASK) == KINGSIDE_CASTLE_MOVE_MASK;
+        U64 king_start = (this->color == WHITE) ? WHITE_KING_START : BLACK_KING_START;
+        U64 king_rook, new_king, new_rook;
 
-        if (!moves_for_piece.size()) {
-            // No valid moves for this piece
-            continue;
+        if (this->color == WHITE) {
+            king_rook = kingside ? WHITE_CASTLE_KINGSIDE_MASK : WHITE_CASTLE_QUEENSIDE_MASK;
+            new_king  = kingside ? WHITE_CASTLE_KINGSIDE_KING_MOVE : WHITE_CASTLE_QUEENSIDE_KING_MOVE;
+            new_rook  = kingside ? WHITE_CASTLE_KINGSIDE_ROOK_MOVE : WHITE_CASTLE_QUEENSIDE_ROOK_MOVE;
+        } else { // this->color == BLACK
+            king_rook = kingside ? BLACK_CASTLE_KINGSIDE_MASK : BLACK_CASTLE_QUEENSIDE_MASK;
+            new_king  = kingside ? BLACK_CASTLE_KINGSIDE_KING_MOVE : BLACK_CASTLE_QUEENSIDE_KING_MOVE;
+            new_rook  = kingside ? BLACK_CASTLE_KINGSIDE_ROOK_MOVE : BLACK_CASTLE_QUEENSIDE_ROOK_MOVE;
         }
 
-        // Set the piece type mask
-        piece_move_mask = 0;
-        switch (piecemoves[p].move_type) {
-            case KING:
-                piece_move_mask |= KING_MOVE_MASK;
-                break;
-            case QUEEN:
-                piece_move_mask |= QUEEN_MOVE_MASK;
-                break;
-            case BISHOP:
-                piece_move_mask |= BISHOP_MOVE_MASK;
-                break;
-            case ROOK:
-                piece_move_mask |= ROOK_MOVE_MASK;
-                break;
-            case KNIGHT:
-                piece_move_mask |= KNIGHT_MOVE_MASK;
-                break;
-            default: // Default to pawn
-                piece_move_mask |= PAWN_MOVE_MASK;
-                break;
+        this->move_piece(WK + offset, new_king, king_start);
+        this->move_piece(WR + offset, new_rook, king_rook & ~king_start);
+    } else {
+        U64 from = FILE_RANK_MOVE_MASK_TO_PIECE__FROM[(move & FROM_FILE_RANK_MOVE_MASK) >> FROM_MOVE_SHIFT];
+        U64 to   = FILE_RANK_MOVE_MASK_TO_PIECE__TO[(move & TO_FILE_RANK_MOVE_MASK) >> TO_MOVE_SHIFT];
+        int moving = MOVE_MASK_TO_BITBOARD_INDEX[move & PIECE_MOVE_MASK] + offset;
+        bool pawn_moving = (move & PIECE_MOVE_MASK) == PAWN_MOVE_MASK;
+
+        if (pawn_moving && (move & PROMO_MOVE_MASK)) {
+            this->toggle_piece(this->get_piece_on(to, this->color), to);
+            this->toggle_piece(moving, from);
+        } else {
+            this->move_piece(moving, to, from);
         }
 
-        // Generate moves
-        int rand_promotion_index;
-        for (int m = 0; m < moves_for_piece.size(); m++) {
-            if (moves_for_piece[m]) {
-                move = piece_move_mask;
-                move |= PIECE_TO_FILE_RANK_MOVE_MASK__FROM[piecemoves[p].piece];
-                move |= (moves_for_piece[m] & enemy_pieces) ? ATTACK_MOVE_MASK : 0;
-                move |= PIECE_TO_FILE_RANK_MOVE_MASK__TO[moves_for_piece[m]];
-
-                if (((piece_move_mask & PAWN_MOVE_MASK) == PAWN_MOVE_MASK) && ((piecemoves[p].piece & RANK_2 && this->color == BLACK) || (piecemoves[p].piece & RANK_7 && this->color == WHITE))) {
-                    // This pawn can be promoted. Choose promotion type randomly
-                    rand_promotion_index = rand() % LEN_PAWN_PROMOTION_CHOICES;
-                    move |= PAWN_PROMOTION_MOVE_MASK_CHOICES[rand_promotion_index];
-                }
+        if (undo.captured != -1) {
+            U64 captured_square = to;
 
-                moves.emplace_back(move);
-            }
+            if (pawn_moving && undo.en_passant_square != NO_EN_PASSANT_SQUARE && to == shift_left(1, undo.en_passant_square))
+                captured_square = (this->color == WHITE) ? shift_left(to, 8) : shift_right(to, 8);
+
+            this->toggle_piece(undo.captured, captured_square);
         }
     }
 
-    for (int c = 0; c < castling_moves.size(); c++)
-        moves.emplace_back(castling_moves[c]);
+    this->castling_rights = undo.castling_rights;
+    this->en_passant_square = undo.en_passant_square;
+    this->half_moves = undo.half_moves;
+    this->key = undo.key;
 
-    this->stalemate = !moves.size() && !this->in_check;
+#ifdef DEBUG_ZOBRIST
+    if (this->key != this->compute_key()) {
+        std::cerr << "Zobrist key mismatch after taking back " << get_move_str(move) << std::endl;
+        abort();
+    }
+#endif
+}
+
+// Passes the turn without moving (a null move), saving what is needed to take it back in undo
+// The en passant square goes, as a real move would take it away too
+void ChessBoard::make_null_move(UndoInfo &undo) {
+    undo.key = this->key;
+    undo.captured = -1;
+    undo.castling_rights = this->castling_rights;
+    undo.en_passant_square = this->en_passant_square;
+    undo.half_moves = this->half_moves;
+
+    if (this->en_passant_square != NO_EN_PASSANT_SQUARE)
+        this->key ^= ZOBRIST_EN_PASSANT_FILE[this->en_passant_square % 8];
+
+    this->en_passant_square = NO_EN_PASSANT_SQUARE;
+    this->half_moves++;
+    this->key ^= ZOBRIST_BLACK_TO_MOVE;
+
+    if (this->color == BLACK)
+        this->whole_moves++;
+
+    this->color = this->get_enemy_color(this->color);
+}
+
+// Takes back the last null move made with make_null_move, using the saved undo info
+void ChessBoard::unmake_null_move(const UndoInfo &undo) {
+    this->color = this->get_enemy_color(this->color);
+
+    if (this->color == BLACK)
+        this->whole_moves--;
+
+    this->en_passant_square = undo.en_passant_square;
+    this->half_moves = undo.half_moves;
+    this->key = undo.key;
 }
 
 // Returns a new ChessBoard object with move applied
-ChessBoard ChessBoard::apply_move(int move) {
-    bool attack = false;
-    bool pawn_promotion = false;
-    bool pawn_moving = false;
-
-    int pawn_promotion_bitboard_index;
-    int new_king_bitboard_index = -1;
-    int new_rook_bitboard_index = -1;
-
-    U64 old_king_rook = 0;
-    U64 new_king = 0;
-    U64 new_rook = 0; 
-    U64 from = 0;
-    U64 to = 0; 
-
-    ChessBoard new_board = ChessBoard();
-    
-    if (!(move & CASTLE_MOVE_MASK)) { 
-        // This move does not involve castling
-        attack = move & ATTACK_MOVE_MASK;
-        
-        // Get start (from) & end (to) piece masks
-        from = FILE_RANK_MOVE_MASK_TO_PIECE__FROM[move & (FROM_FILE_MOVE_MASK | FROM_RANK_MOVE_MASK)];
-        to   = FILE_RANK_MOVE_MASK_TO_PIECE__TO[move & (TO_FILE_MOVE_MASK | TO_RANK_MOVE_MASK)];
-            
-        pawn_moving = (move & PIECE_MOVE_MASK) == PAWN_MOVE_MASK;
-        pawn_promotion = pawn_moving && (move & PROMO_MOVE_MASK);
-        
-        if (pawn_promotion) {
-            if ((move & PROMO_MOVE_MASK) == QUEEN_PROMO_MOVE_MASK)
-                pawn_promotion_bitboard_index = (this->color == WHITE) ? WQ : BQ;
-            else if ((move & PROMO_MOVE_MASK) == BISHOP_PROMO_MOVE_MASK)
-                pawn_promotion_bitboard_index = (this->color == WHITE) ? WB : BB;
-            else if ((move & PROMO_MOVE_MASK) == ROOK_PROMO_MOVE_MASK)
-                pawn_promotion_bitboard_index = (this->color == WHITE) ? WR : BR;
-            else // (move & PROMO_MOVE_MASK) == KNIGHT_PROMO_MOVE_MASK
-                pawn_promotion_bitboard_index = (this->color == WHITE) ? WN : BN;
-        }
-        
-        // Check for en passant opportunity
-        if ((this->color == WHITE) && (from == (to << 16)))
-            new_board.en_passant_str = PIECE_TO_FILE_RANK[to << 8];
-        
-        else if ((this->color == WHITE) && (from == (to >> 16)))
-            new_board.en_passant_str = PIECE_TO_FILE_RANK[to >> 8];
-        
-        else
-            new_board.en_passant_str = NO_EN_PASSANT_STR;
-        
-        // Castling did not occur
-        new_board.white_can_castle_kingside = this->white_can_castle_kingside;
-        new_board.white_can_castle_queenside = this->white_can_castle_queenside;
-        new_board.black_can_castle_kingside = this->black_can_castle_kingside;
-        new_board.black_can_castle_queenside = this->black_can_castle_queenside;
-    } else {
-        // Castling ocurred
-        if ((move & CASTLE_MOVE_MASK) == KINGSIDE_CASTLE_MOVE_MASK) {
-            if (this->color == WHITE) {
-                new_board.white_can_castle_kingside = false;
-                new_board.white_can_castle_queenside = false;
-
-                old_king_rook = WHITE_CASTLE_KINGSIDE_MASK;
-                new_king = WHITE_CASTLE_KINGSIDE_KING_MOVE;
-                new_rook = WHITE_CASTLE_KINGSIDE_ROOK_MOVE;
-                new_king_bitboard_index = WK;
-                new_rook_bitboard_index = WR;
-            } else { // this->color == BLACK 
-                new_board.black_can_castle_kingside = false;
-                new_board.black_can_castle_queenside = false;
-
-                old_king_rook = BLACK_CASTLE_KINGSIDE_MASK;
-                new_king = BLACK_CASTLE_KINGSIDE_KING_MOVE;
-                new_rook = BLACK_CASTLE_KINGSIDE_ROOK_MOVE;
-                new_king_bitboard_index = BK;
-                new_rook_bitboard_index = BR;
-            }
-        } else { // (move & CASTLE_MOVE_MASK) == QUEENSIDE_CASTLE_MOVE_MASK
-            if (this->color == WHITE) {
-                new_board.white_can_castle_kingside = false;
-                new_board.white_can_castle_queenside = false;
-
-                old_king_rook = WHITE_CASTLE_QUEENSIDE_MASK;
-                new_king = WHITE_CASTLE_QUEENSIDE_KING_MOVE;
-                new_rook = WHITE_CASTLE_QUEENSIDE_ROOK_MOVE;
-                new_king_bitboard_index = WK;
-                new_rook_bitboard_index = WR;
-            } else { // this->color == BLACK
-                new_board.black_can_castle_kingside = false;
-                new_board.black_can_castle_queenside = false;
-
-                old_king_rook = BLACK_CASTLE_QUEENSIDE_MASK;
-                new_king = BLACK_CASTLE_QUEENSIDE_KING_MOVE;
-                new_rook = BLACK_CASTLE_QUEENSIDE_ROOK_MOVE;
-                new_king_bitboard_index = BK;
-                new_rook_bitboard_index = BR;
-            }
-        }
-            
-        // No en passant possible after this move
-        new_board.en_passant_str = NO_EN_PASSANT_STR;
-    }
-    
-    // Update half moves & whole moves
-    if (pawn_moving || attack)
-        new_board.half_moves = 0;
-
-    else
-        new_board.half_moves = this->half_moves + 1;
-    
-    new_board.whole_moves = (this->color == BLACK) ? this->whole_moves + 1 : this->whole_moves;
-
-    // Update active color
-    new_board.color = (this->color == WHITE) ? BLACK : WHITE;
-    
-    // Update piece locations
-    for (int bitboard_index = 0; bitboard_index < NUM_BITBOARDS; bitboard_index++) {
-        // Check castling
-        if (old_king_rook & this->bitboards[bitboard_index]) {
-            new_board.bitboards[bitboard_index] = this->bitboards[bitboard_index] & (~old_king_rook);
-            
-            if (bitboard_index == new_king_bitboard_index) {
-                new_board.bitboards[bitboard_index] = this->bitboards[bitboard_index] | new_king;
-            } else { // bitboard_index == new_rook_bitboard_index
-                new_board.bitboards[bitboard_index] = this->bitboards[bitboard_index] | new_rook;
-            }
-        }
-        
-        if (attack && (to & this->bitboards[bitboard_index])) {
-            // Remove attacked piece
-            new_board.bitboards[bitboard_index] = this->bitboards[bitboard_index] & ~to;
-        } else if (pawn_promotion) {
-            if (bitboard_index == pawn_promotion_bitboard_index) {
-                // Promotion bitboard
-                new_board.bitboards[bitboard_index] = this->bitboards[bitboard_index] | to;
-            } else {
-                // Pawn bitboard    
-                new_board.bitboards[bitboard_index] = this->bitboards[bitboard_index] & ~from;
-            }
-        } else if (from & this->bitboards[bitboard_index]) {
-            // Move this piece on its bitboard
-            new_board.bitboards[bitboard_index] = (this->bitboards[bitboard_index] | to) & ~from;
-        } else {
-            // No moves made on these bitboards
-            new_board.bitboards[bitboard_index] = this->bitboards[bitboard_index];
-        }
-        
-        // if (from & this->bitboards[bitboard_index]) {
-        //     // A piece is moving on this bitboard
-        //     new_board.bitboards[bitboard_index] = (this->bitboards[bitboard_index] & ~from) | to;
-        // } else if (to & this->bitboards[bitboard_index]) {
-        //     // A piece is being *captured* (and removed) from this bitboard
-        //     new_board.bitboards[bitboard_index] = this->bitboards[bitboard_index] & ~to;
-        // }
-        // else {
-        //     new_board.bitboards[bitboard_index] = this->bitboards[bitboard_index];    
-        // }
-    }    
-    
+ChessBoard ChessBoard::apply_move(int move) const {
+    ChessBoard new_board = *this;
+    UndoInfo undo;
+
+    new_board.make_move(move, undo);
+
     return new_board;
 }
@@ -2,50 +2,95 @@
 #define CHESSBOARD_HPP
 
 #include "constants.hpp"
-#include "piecemoves.hpp"
+#include "magic.hpp"
+#include "movelist.hpp"
 #include "util.hpp"
+#include "zobrist.hpp"
 #include <algorithm>
+#include <array>
+#include <cstdint>
 #include <iostream>
-#include <set>
 #include <stdlib.h>
+#include <type_traits>
 #include <vector>
 
+// The parts of a board make_move() overwrites that can't be recovered from the move itself
+struct UndoInfo {
+    U64 key;
+    int8_t captured;          // Bitboard index of the captured piece, -1 if nothing was captured
+    uint8_t castling_rights;
+    int8_t en_passant_square;
+    uint8_t half_moves;
+};
+
 class ChessBoard {
 private:
-    U64 get_rook_moves(U64 rook, bool color, bool hypothetical);
-    U64 get_bishop_moves(U64 bishop, bool color, bool hypothetical);
-    bool get_enemy_color(bool color);
-    void get_moves_for_color(std::vector<PieceMoves> &moves_for_color, bool color, bool hypothetical = false);
-    U64 get_white(void);
-    U64 get_black(void);
-    U64 get_empty(void);
-    U64 get_king_killshots(U64 king, PieceMoves enemy_piecemoves);
-    bool is_sliding_move(int move_type);
-    int get_king_index_from_piecemoves_list(std::vector<PieceMoves> piecemoves);
-    U64 get_pinner(U64 king, U64 piece, std::vector<PieceMoves> enemy_piecemoves);
-    U64 remove_sliding_path_moves(U64 king, U64 king_moves, std::vector<PieceMoves> enemy_piecemoves);
-    U64 get_canceling_moves(PieceMoves piecemove, std::vector<PieceMoves> moves_attacking_king);
-    void get_castling_moves(std::vector<int> &castling_moves, bool color, U64 all_enemy_moves, U64 king, U64 rooks);
+    bool get_enemy_color(bool color) const;
+    void add_moves(MoveList &moves, int piece_move_mask, int from, U64 targets, U64 enemy);
+    void add_pawn_moves(MoveList &moves, int from, U64 targets, U64 enemy);
+    bool can_castle(int castle_move_mask) const;
+    int get_piece_on(U64 square, bool color) const;
+    void move_piece(int bitboard_index, U64 from, U64 to);
+    void toggle_piece(int bitboard_index, U64 square);
 
 public:
-    std::vector<U64> bitboards;
-    bool white_can_castle_kingside;
-    bool white_can_castle_queenside;
-    bool black_can_castle_kingside;
-    bool black_can_castle_queenside;
+    // The board is trivially copyable so copies are a plain memcpy
+    std::array<U64, NUM_BITBOARDS> bitboards;
+    std::array<U64, NUM_COLORS> occupancy; // All pieces of each color, kept in sync with bitboards
+    U64 key;                               // Zobrist key, kept in sync by make_move()
+    uint16_t whole_moves;
+    uint8_t half_moves;
+    uint8_t castling_rights;  // *_CASTLE_RIGHT flags
+    int8_t en_passant_square; // NO_EN_PASSANT_SQUARE if there is none or no pawn can capture there
+    bool color;
     bool stalemate;
     bool in_check;
-    std::string en_passant_str;
-    int half_moves;
-    int whole_moves;
-    bool color;
 
     ChessBoard(std::string fen="");
-    void actions(std::vector<int> &moves);
+    void actions(MoveList &moves, int mode=ALL_MOVES);
+    bool update_in_check(void);
+    bool is_legal(int move) const;
+    U64 attackers_to(int square, U64 occupied) const;
     U64 get_bitboard(int bitboard_index);
-    U64 get_all(void);
-    void get_moves(std::vector<int> &moves, std::vector<PieceMoves> piecemoves, std::vector<int> castling_moves, std::unordered_map<U64, U64> blacklist);
-    ChessBoard apply_move(int move);
+    void update_occupancy(void);
+    U64 compute_key(void) const;
+    int capture_gain(int move) const;
+    int see(int move) const;
+
+    // Returns true if move's static exchange evaluation is at least threshold
+    bool see_ge(int move, int threshold) const {
+        return this->see(move) >= threshold;
+    }
+
+    U64 get_white(void) const {
+        return this->occupancy[WHITE];
+    }
+
+    U64 get_black(void) const {
+        return this->occupancy[BLACK];
+    }
+
+    U64 get_all(void) const {
+        return this->occupancy[WHITE] | this->occupancy[BLACK];
+    }
+
+    // Returns true if color has a piece other than its king & pawns
+    bool has_non_pawn_material(bool color) const {
+        int offset = (color == WHITE) ? 0 : BLACK_BITBOARD_OFFSET;
+        return (this->bitboards[WQ + offset] | this->bitboards[WR + offset] |
+                this->bitboards[WB + offset] | this->bitboards[WN + offset]) != 0;
+    }
+
+    void make_move(int move, UndoInfo &undo);
+    void unmake_move(int move, const UndoInfo &undo);
+    void make_null_move(UndoInfo &undo);
+    void unmake_null_move(const UndoInfo &undo);
+    ChessBoard apply_move(int move) const;
 };
 
+static_assert(std::is_trivially_copyable<ChessBoard>::value, "ChessBoard must stay trivially copyable");
+
+// 15 U64s (bitboards, occupancy & key) take 120 bytes, the rest rounds it up to two cache lines
+static_assert(sizeof(ChessBoard) <= 128, "ChessBoard should fit in two cache lines");
+
 #endif // CHESSBOARD_HPP
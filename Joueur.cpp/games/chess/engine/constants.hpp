@@ -12,11 +12,32 @@ typedef uint64_t U64;
 constexpr int BITBOARD_SIZE = 64;
 constexpr U64 UNIVERSAL_SET = 0xFFFFFFFFFFFFFFFF;
 const std::string NO_EN_PASSANT_STR = "-";
+constexpr int NO_EN_PASSANT_SQUARE = -1;
 constexpr bool WHITE = 0;
 constexpr bool BLACK = 1;
-constexpr int MAX_NUM_MOVES = 100;
-constexpr int ESTIMATED_REMAINING_MOVES = 40;
-constexpr int MAX_QS_DEPTH = 3;
+constexpr int NUM_COLORS = 2;
+constexpr int NUM_FILES = 8;
+constexpr int NUM_CASTLING_RIGHTS_STATES = 16; // Every combination of the *_CASTLE_RIGHT flags
+constexpr int MAX_NUM_MOVES = 256;      // Capacity of a MoveList (no position has more legal moves)
+constexpr int QS_DELTA_MARGIN = 1;      // Pawns a capture may swing the evaluation beyond its material, for delta pruning
+constexpr int TIME_CHECK_NODES = 256;   // Nodes between clock polls, must be a power of 2
+constexpr int ASPIRATION_WIDTH = 1;     // Half width of the first window around the previous depth's score, 0 for none
+constexpr int ASPIRATION_MAX_WIDTH = 8; // Past this half width the window is opened all the way
+constexpr int MAX_PLY = 128;           // Deepest ply the search stack holds
+constexpr int NUM_KILLERS = 2;
+constexpr int CONTINUATION_PLIES = 2;  // Earlier moves the continuation history follows on from
+constexpr int MAX_QUIETS_SEARCHED = 64; // Quiet moves a node remembers searching, for the history malus
+constexpr int NULL_MOVE_MIN_DEPTH = 3;     // Shallowest depth a null move is tried at
+constexpr int NULL_MOVE_REDUCTION = 2;     // Plies a null move search is reduced by, plus depth / NULL_MOVE_DEPTH_DIVISOR
+constexpr int NULL_MOVE_DEPTH_DIVISOR = 4;
+constexpr int NULL_MOVE_VERIFY_DEPTH = 8;  // Null move cutoffs from at least this deep are verified
+
+// Move ordering scores, each band above everything in the bands below it
+constexpr int GOOD_CAPTURE_SCORE = 1 << 28; // Plus MVV-LVA, for captures & promotions SEE doesn't lose on
+constexpr int KILLER_MOVE_SCORE = 1 << 26; // Less the killer's slot
+constexpr int COUNTER_MOVE_SCORE = 1 << 25;
+constexpr int BAD_CAPTURE_SCORE = -(1 << 28); // Plus MVV-LVA, below every quiet move
+constexpr int HISTORY_MAX = 1 << 14;       // History entries saturate at +/- this
 
 constexpr U64 FILE_A = 0x0101010101010101;
 constexpr U64 FILE_B = 0x0202020202020202;
@@ -54,25 +75,38 @@ constexpr char RANK_6_CHAR = '6';
 constexpr char RANK_7_CHAR = '7';
 constexpr char RANK_8_CHAR = '8';
 
+constexpr U64 WHITE_KING_START = 0x1000000000000000;
+constexpr U64 BLACK_KING_START = 0x0000000000000010;
+
+// *_MASK holds the king & rook start squares, *_INVALID the squares that must be empty,
+// *_KING_MOVE and *_ROOK_MOVE the squares the king & rook land on
 constexpr U64 WHITE_CASTLE_KINGSIDE_MASK = 0x9000000000000000;
 constexpr U64 WHITE_CASTLE_KINGSIDE_INVALID = 0x6000000000000000;
-constexpr U64 WHITE_CASTLE_KINGSIDE_KING_MOVE = 0x2000000000000000;
-constexpr U64 WHITE_CASTLE_KINGSIDE_ROOK_MOVE = 0x1000000000000000;
+constexpr U64 WHITE_CASTLE_KINGSIDE_KING_MOVE = 0x4000000000000000;
+constexpr U64 WHITE_CASTLE_KINGSIDE_ROOK_MOVE = 0x2000000000000000;
 
 constexpr U64 WHITE_CASTLE_QUEENSIDE_MASK = 0x1100000000000000;
 constexpr U64 WHITE_CASTLE_QUEENSIDE_INVALID = 0x0E00000000000000;
-constexpr U64 WHITE_CASTLE_QUEENSIDE_KING_MOVE = 0x0800000000000000;
-constexpr U64 WHITE_CASTLE_QUEENSIDE_ROOK_MOVE = 0x1000000000000000;
+constexpr U64 WHITE_CASTLE_QUEENSIDE_KING_MOVE = 0x0400000000000000;
+constexpr U64 WHITE_CASTLE_QUEENSIDE_ROOK_MOVE = 0x0800000000000000;
 
 constexpr U64 BLACK_CASTLE_KINGSIDE_MASK = 0x0000000000000090;
 constexpr U64 BLACK_CASTLE_KINGSIDE_INVALID = 0x0000000000000060;
-constexpr U64 BLACK_CASTLE_KINGSIDE_KING_MOVE = 0x0000000000000020;
-constexpr U64 BLACK_CASTLE_KINGSIDE_ROOK_MOVE = 0x0000000000000010;
+constexpr U64 BLACK_CASTLE_KINGSIDE_KING_MOVE = 0x0000000000000040;
+constexpr U64 BLACK_CASTLE_KINGSIDE_ROOK_MOVE = 0x0000000000000020;
 
 constexpr U64 BLACK_CASTLE_QUEENSIDE_MASK = 0x0000000000000011;
 constexpr U64 BLACK_CASTLE_QUEENSIDE_INVALID = 0x000000000000000E;
-constexpr U64 BLACK_CASTLE_QUEENSIDE_KING_MOVE = 0x0000000000000008;
-constexpr U64 BLACK_CASTLE_QUEENSIDE_ROOK_MOVE = 0x0000000000000010;
+constexpr U64 BLACK_CASTLE_QUEENSIDE_KING_MOVE = 0x0000000000000004;
+constexpr U64 BLACK_CASTLE_QUEENSIDE_ROOK_MOVE = 0x0000000000000008;
+
+// Castling rights flags
+constexpr int WHITE_CASTLE_KINGSIDE_RIGHT  = 0x1;
+constexpr int WHITE_CASTLE_QUEENSIDE_RIGHT = 0x2;
+constexpr int BLACK_CASTLE_KINGSIDE_RIGHT  = 0x4;
+constexpr int BLACK_CASTLE_QUEENSIDE_RIGHT = 0x8;
+constexpr int WHITE_CASTLE_RIGHTS = WHITE_CASTLE_KINGSIDE_RIGHT | WHITE_CASTLE_QUEENSIDE_RIGHT;
+constexpr int BLACK_CASTLE_RIGHTS = BLACK_CASTLE_KINGSIDE_RIGHT | BLACK_CASTLE_QUEENSIDE_RIGHT;
 
 // Move encoding
 constexpr int KING_MOVE_MASK   = 0x00000001;
@@ -83,6 +117,7 @@ constexpr int KNIGHT_MOVE_MASK = 0x00000005;
 constexpr int PAWN_MOVE_MASK   = 0x00000006;
 
 constexpr int PIECE_MOVE_MASK  = 0x00000007;
+constexpr int NUM_PIECE_TYPES  = 6; // Piece move masks less 1, see get_piece_index()
 
 constexpr int FROM_FILE_A_MOVE_MASK = 0x00000010;
 constexpr int FROM_FILE_B_MOVE_MASK = 0x00000020;
@@ -128,6 +163,12 @@ constexpr int TO_RANK_8_MOVE_MASK = 0x00080000;
 
 constexpr int TO_RANK_MOVE_MASK   = 0x000F0000;
 
+constexpr int FROM_FILE_RANK_MOVE_MASK = FROM_FILE_MOVE_MASK | FROM_RANK_MOVE_MASK;
+constexpr int TO_FILE_RANK_MOVE_MASK   = TO_FILE_MOVE_MASK | TO_RANK_MOVE_MASK;
+constexpr int FROM_MOVE_SHIFT = 4;
+constexpr int TO_MOVE_SHIFT   = 12;
+constexpr int NUM_FILE_RANK_MOVE_MASKS = 0x100;
+
 constexpr int KINGSIDE_CASTLE_MOVE_MASK  = 0x00100000;
 constexpr int QUEENSIDE_CASTLE_MOVE_MASK = 0x00200000;
 constexpr int CASTLE_MOVE_MASK           = 0x00300000;
@@ -160,6 +201,18 @@ enum BitboardIndices {
     NUM_BITBOARDS
 };
 
+// Offset from a white bitboard index to the matching black one
+constexpr int BLACK_BITBOARD_OFFSET = BK - WK;
+
+// White bitboard index for each *_MOVE_MASK piece type
+constexpr int MOVE_MASK_TO_BITBOARD_INDEX[PAWN_MOVE_MASK + 1] = {-1, WK, WQ, WB, WR, WN, WP};
+
+// PIECE_WEIGHTS by bitboard index for static exchange evaluation, where the king outweighs everything
+constexpr int SEE_VALUES[NUM_BITBOARDS] = {100, 9, 3, 3, 5, 1, 100, 9, 3, 3, 5, 1};
+
+// White bitboard indices from least to most valuable, the order recaptures are tried in
+constexpr int SEE_ATTACKER_ORDER[NUM_BITBOARDS / 2] = {WP, WN, WB, WR, WQ, WK};
+
 const std::vector<int> WHITE_BITBOARD_INDICES = {WK, WQ, WB, WN, WR, WP};
 const std::vector<int> BLACK_BITBOARD_INDICES = {BK, BQ, BB, BN, BR, BP};
 
@@ -171,11 +224,71 @@ enum TerminalTestResults {
     DEPTH_LIMIT_REACHED,
 };
 
-#define INIT_ALPHA INT_MIN
-#define INIT_BETA INT_MAX
-#define MAX_VALUE (INT_MAX - 1)
-#define MIN_VALUE (INT_MIN + 1)
+// Scores must fit in the transposition table's 16 bit score field
+#define MAX_VALUE 32000
+#define MIN_VALUE (-MAX_VALUE)
+#define INIT_ALPHA (MIN_VALUE - 1)
+#define INIT_BETA (MAX_VALUE + 1)
 #define DRAW_VALUE 0
+#define ABORTED_VALUE 0 // Returned by a stopped search, callers check the stop before using it
+
+// Transposition table
+constexpr int DEFAULT_TT_MEGABYTES = 64;
+constexpr int TT_BUCKET_SIZE = 4; // Entries per 64 byte bucket
+
+// Time management
+constexpr int STARTING_NON_PAWN_MATERIAL = 62; // Both sides' PIECE_WEIGHTS before any pieces are traded
+constexpr double TM_MIN_MOVES_TO_GO = 20;      // Moves assumed left with nothing but pawns
+constexpr double TM_MAX_MOVES_TO_GO = 50;      // Moves assumed left with every piece on the board
+constexpr double TM_EXPECTED_GAME_LENGTH = 80; // Moves assumed left from the start, ignoring the phase
+constexpr double TM_INCREMENT_USE = 0.75;      // Share of each increment spent on the move it's earned on
+constexpr double TM_HARD_RATIO = 4;            // Hard maximum as a multiple of the soft target
+constexpr double TM_MAX_CLOCK_SHARE = 0.2;     // Most of the clock one move may use
+constexpr double TM_STABILITY_STEP = 0.1;      // Soft target shrinks by this much per iteration the best move holds
+constexpr double TM_MIN_STABILITY_SCALE = 0.5;
+constexpr double TM_INSTABILITY_WEIGHT = 0.5;  // Soft target grows by this much per recent best move change
+constexpr double TM_INSTABILITY_DECAY = 0.5;   // Per iteration
+constexpr double TM_SCORE_DROP_WEIGHT = 0.5;   // Soft target grows by this much per pawn the score drops
+constexpr double TM_MAX_SCORE_DROP_SCALE = 2;
+constexpr double TM_DEFAULT_OVERHEAD_NS = 50e6; // Assumed per move overhead until one has been measured
+constexpr int TM_OVERHEAD_SAMPLES = 16;        // Recent moves the overhead estimate is taken over
+constexpr double TM_OVERHEAD_PERCENTILE = 0.9;
+constexpr double TM_MIN_THINK_NS = 1e6;        // Least time a move is given, however little is left
+constexpr double TM_MIN_GROWTH = 2;            // Bounds on how much longer the next iteration is expected to take
+constexpr double TM_MAX_GROWTH = 8;
+
+// Move generation
+enum GenerationModes {
+    ALL_MOVES,      // Every legal move, only the evasions when in check
+    TACTICAL_MOVES, // Captures & promotions
+    QUIET_MOVES,    // Every legal move that isn't tactical, castling included
+};
+
+// MovePicker stages, gone through in order until a cutoff
+// A stage's moves are only generated once the stages before it are used up
+enum PickerStages {
+    HASH_MOVE_STAGE,
+    GENERATE_CAPTURES_STAGE,
+    GOOD_CAPTURES_STAGE,     // Captures & promotions SEE doesn't lose on
+    KILLERS_STAGE,
+    COUNTER_MOVE_STAGE,
+    GENERATE_QUIETS_STAGE,
+    QUIETS_STAGE,            // By history
+    BAD_CAPTURES_STAGE,
+    GENERATE_EVASIONS_STAGE, // In check every evasion is picked from one list instead
+    EVASIONS_STAGE,
+    DONE_STAGE,
+};
+
+// Parallel search
+enum SearchModes {
+    LAZY_SMP_MODE, // Independent searches sharing the transposition table
+    YBWC_MODE,     // Young Brothers Wait tree splitting
+};
+
+constexpr int YBWC_MIN_SPLIT_DEPTH = 2; // Shallower nodes aren't worth handing out
+constexpr int YBWC_MAX_SPLITS = 128;    // Split points one thread can have open at once
+constexpr int WORK_DEQUE_SIZE = 1024;   // Tasks a thread's deque holds, must be a power of 2
 
 // Piece weight indices match the *_BITBOARD_INDICES vectors
 // Source: https://en.wikipedia.org/wiki/Chess_piece_relative_value
@@ -227,14 +340,4 @@ enum SplitFenIndices {
     WHOLE_MOVES
 };
 
-enum MoveTypes {
-    KING,
-    QUEEN,
-    BISHOP,
-    ROOK,
-    KNIGHT,
-    PAWN,
-    PAWN_ATTACK,
-};
-
 #endif // CONSTANTS_HPP
@@ -0,0 +1,48 @@
+#ifndef MAGIC_HPP
+#define MAGIC_HPP
+
+#include "constants.hpp"
+#include "util.hpp"
+
+constexpr int ROOK_ATTACK_TABLE_SIZE = 102400;
+constexpr int BISHOP_ATTACK_TABLE_SIZE = 5248;
+
+// Magic bitboard lookup data for a single square
+struct Magic {
+    U64 mask;     // Relevant occupancy mask (board edges excluded)
+    U64 magic;    // Magic multiplier
+    U64 *attacks; // This square's slice of the shared attack table
+    int shift;    // 64 - number of bits in mask
+
+    // Returns the attack table index for the given occupancy
+    unsigned int index(U64 occupied) const {
+        return (unsigned int)(((occupied & this->mask) * this->magic) >> this->shift);
+    }
+};
+
+extern Magic ROOK_MAGICS[BITBOARD_SIZE];
+extern Magic BISHOP_MAGICS[BITBOARD_SIZE];
+
+bool init_magics(void);
+extern bool MAGICS_INITIALIZED;
+
+bool verify_magic_attacks(int num_trials);
+
+// Returns the squares attacked by a rook on square given the board occupancy
+inline U64 rook_attacks(int square, U64 occupied) {
+    const Magic &m = ROOK_MAGICS[square];
+    return m.attacks[m.index(occupied)];
+}
+
+// Returns the squares attacked by a bishop on square given the board occupancy
+inline U64 bishop_attacks(int square, U64 occupied) {
+    const Magic &m = BISHOP_MAGICS[square];
+    return m.attacks[m.index(occupied)];
+}
+
+// Returns the squares attacked by a queen on square given the board occupancy
+inline U64 queen_attacks(int square, U64 occupied) {
+    return rook_attacks(square, occupied) | bishop_attacks(square, occupied);
+}
+
+#endif // MAGIC_HPP
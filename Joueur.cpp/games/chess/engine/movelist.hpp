@@ -0,0 +1,89 @@
+#ifndef MOVELIST_HPP
+#define MOVELIST_HPP
+
+#include "constants.hpp"
+#include <utility>
+
+// Fixed-capacity list of moves that lives on the stack, so move generation never allocates.
+// Each move has a score slot that move ordering can fill in.
+struct MoveList {
+    int moves[MAX_NUM_MOVES];
+    int scores[MAX_NUM_MOVES];
+    int count;
+
+    MoveList() : count(0) {}
+
+    void push(int move) {
+        this->moves[this->count++] = move;
+    }
+
+    void clear(void) {
+        this->count = 0;
+    }
+
+    int size(void) const {
+        return this->count;
+    }
+
+    bool empty(void) const {
+        return this->count == 0;
+    }
+
+    // Moves move (if present) to the front, keeping the order of the others
+    void move_to_front(int move) {
+        for (int i = 0; i < this->count; i++) {
+            if (this->moves[i] == move) {
+                for (; i > 0; i--)
+                    this->moves[i] = this->moves[i - 1];
+
+                this->moves[0] = move;
+                return;
+            }
+        }
+    }
+
+    // Swaps the highest scored move from index on into index and returns it, so
+    // picking index 0, 1, 2... is a selection sort that stops at the first cutoff
+    int pick(int index) {
+        return this->pick(index, this->count);
+    }
+
+    // pick() among the moves before end only
+    int pick(int index, int end) {
+        int best = index;
+        for (int i = index + 1; i < end; i++) {
+            if (this->scores[i] > this->scores[best])
+                best = i;
+        }
+
+        std::swap(this->moves[index], this->moves[best]);
+        std::swap(this->scores[index], this->scores[best]);
+        return this->moves[index];
+    }
+
+    int &operator[](int index) {
+        return this->moves[index];
+    }
+
+    int operator[](int index) const {
+        return this->moves[index];
+    }
+
+    int *begin(void) {
+        return this->moves;
+    }
+
+    int *end(void) {
+        return this->moves + this->count;
+    }
+
+    const int *begin(void) const {
+        return this->moves;
+    }
+
+    const int *end(void) const {
+        return this->moves + this->count;
+    }
+};
+
+#endif // MOVELIST_HPP
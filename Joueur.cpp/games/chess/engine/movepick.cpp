@@ -0,0 +1,244 @@
+#include "movepick.hpp"
+#include "util.hpp"
+
+// Returns quiet move's history, following on from the earlier moves whose continuation tables aren't NULL
+static inline int history_score(const ButterflyTable &history, PieceToTable *const continuations[], int move, bool color) {
+    int piece = get_piece_index(move);
+    int to = get_to_square(move, color);
+    int score = history[get_from_square(move, color)][to];
+
+    for (int i = 0; i < CONTINUATION_PLIES; i++) {
+        if (continuations[i])
+            score += (*continuations[i])[piece][to];
+    }
+
+    return score;
+}
+
+// Returns the score of capture or promotion move: MVV-LVA (most valuable victim, then
+// least valuable attacker) in the good band when static exchange doesn't lose material,
+// in the bad band below the quiet moves when it does
+static inline int tactical_score(const ChessBoard &board, int move) {
+    int gain = board.capture_gain(move);
+    int attacker = SEE_VALUES[MOVE_MASK_TO_BITBOARD_INDEX[move & PIECE_MOVE_MASK]];
+    int mvv_lva = gain * (SEE_VALUES[WK] + 1) - attacker;
+
+    // Taking something worth at least the capturer can't lose, skip the exchange
+    if (((move & PROMO_MOVE_MASK) == 0 && gain >= attacker) || board.see_ge(move, 0))
+        return GOOD_CAPTURE_SCORE + mvv_lva;
+
+    return BAD_CAPTURE_SCORE + mvv_lva;
+}
+
+// Picks every move of the current position, starting with hash_move (0 for none)
+MovePicker::MovePicker(State &state, int hash_move, bool in_check) {
+    SearchFrame &frame = state.frame();
+    int *countermove = state.countermove();
+
+    this->state = &state;
+    this->actions = &frame.actions;
+    this->stage = HASH_MOVE_STAGE;
+    this->hash_move = hash_move;
+    this->counter = countermove ? *countermove : 0;
+    this->index = 0;
+    this->end_captures = 0;
+    this->bad_captures = 0;
+    this->in_check = in_check;
+    this->quiescence = false;
+
+    for (int i = 0; i < NUM_KILLERS; i++)
+        this->killers[i] = frame.killers[i];
+
+    if (!hash_move)
+        this->stage = in_check ? GENERATE_EVASIONS_STAGE : GENERATE_CAPTURES_STAGE;
+}
+
+// Picks the quiescence search's moves: the good captures, or every evasion when in check
+MovePicker::MovePicker(State &state, bool in_check) : MovePicker(state, 0, in_check) {
+    this->quiescence = true;
+}
+
+// Returns true if move is one of the killers
+bool MovePicker::is_killer(int move) const {
+    for (int i = 0; i < NUM_KILLERS; i++) {
+        if (move == this->killers[i])
+            return true;
+    }
+
+    return false;
+}
+
+// Returns true if move was handed out ahead of the stage it was generated in
+bool MovePicker::is_refutation(int move) const {
+    return move == this->hash_move || move == this->counter || this->is_killer(move);
+}
+
+// Scores the captures & promotions for pick(), the good ones in order of MVV-LVA ahead of the bad ones
+void MovePicker::score_captures(void) {
+    MoveList &actions = *this->actions;
+
+    for (int i = 0; i < this->end_captures; i++)
+        actions.scores[i] = tactical_score(this->state->board, actions.moves[i]);
+}
+
+// Scores the quiet moves for pick() by history
+void MovePicker::score_quiets(void) {
+    State &state = *this->state;
+    MoveList &actions = *this->actions;
+    bool color = state.board.color;
+    const ButterflyTable &history = state.history[color];
+    PieceToTable *continuations[CONTINUATION_PLIES];
+
+    for (int i = 0; i < CONTINUATION_PLIES; i++)
+        continuations[i] = state.continuation(i + 1);
+
+    for (int i = this->end_captures; i < actions.size(); i++)
+        actions.scores[i] = history_score(history, continuations, actions.moves[i], color);
+}
+
+// Scores the evasions for pick() in the same order the stages would have handed them out in
+void MovePicker::score_evasions(void) {
+    State &state = *this->state;
+    MoveList &actions = *this->actions;
+    bool color = state.board.color;
+    const ButterflyTable &history = state.history[color];
+    PieceToTable *continuations[CONTINUATION_PLIES];
+
+    for (int i = 0; i < CONTINUATION_PLIES; i++)
+        continuations[i] = state.continuation(i + 1);
+
+    for (int i = 0; i < actions.size(); i++) {
+        int move = actions.moves[i];
+
+        if (!is_quiet(move))
+            actions.scores[i] = tactical_score(state.board, move);
+        else if (move == this->killers[0])
+            actions.scores[i] = KILLER_MOVE_SCORE;
+        else if (move == this->killers[1])
+            actions.scores[i] = KILLER_MOVE_SCORE - 1;
+        else if (move == this->counter)
+            actions.scores[i] = COUNTER_MOVE_SCORE;
+        else
+            actions.scores[i] = history_score(history, continuations, move, color);
+    }
+}
+
+// Returns the next move to search, 0 once there are none left
+int MovePicker::next_move(void) {
+    ChessBoard &board = this->state->board;
+    MoveList &actions = *this->actions;
+    int move;
+
+    switch (this->stage) {
+    case HASH_MOVE_STAGE:
+        this->stage = this->in_check ? GENERATE_EVASIONS_STAGE : GENERATE_CAPTURES_STAGE;
+
+        if (board.is_legal(this->hash_move))
+            return this->hash_move;
+
+        return this->next_move();
+
+    case GENERATE_CAPTURES_STAGE:
+        actions.clear();
+        board.actions(actions, TACTICAL_MOVES);
+        this->end_captures = actions.size();
+        this->score_captures();
+        this->index = 0;
+        this->stage = GOOD_CAPTURES_STAGE;
+        // Fall through
+
+    case GOOD_CAPTURES_STAGE:
+        while (this->index < this->end_captures) {
+            move = actions.pick(this->index);
+
+            if (actions.scores[this->index] < 0)
+                // The rest lose material
+                break;
+
+            this->index++;
+
+            if (move != this->hash_move)
+                return move;
+        }
+
+        this->bad_captures = this->index;
+        this->index = 0;
+        this->stage = this->quiescence ? DONE_STAGE : KILLERS_STAGE;
+        return this->quiescence ? 0 : this->next_move();
+
+    case KILLERS_STAGE:
+        while (this->index < NUM_KILLERS) {
+            move = this->killers[this->index++];
+
+            if (move && move != this->hash_move && board.is_legal(move))
+                return move;
+        }
+
+        this->stage = COUNTER_MOVE_STAGE;
+        // Fall through
+
+    case COUNTER_MOVE_STAGE:
+        this->stage = GENERATE_QUIETS_STAGE;
+        move = this->counter;
+
+        if (move && move != this->hash_move && !this->is_killer(move) && board.is_legal(move))
+            return move;
+
+        // Fall through
+
+    case GENERATE_QUIETS_STAGE:
+        // Appended after the captures, the bad ones are still to come
+        board.actions(actions, QUIET_MOVES);
+        this->score_quiets();
+        this->index = this->end_captures;
+        this->stage = QUIETS_STAGE;
+        // Fall through
+
+    case QUIETS_STAGE:
+        while (this->index < actions.size()) {
+            move = actions.pick(this->index++);
+
+            if (!this->is_refutation(move))
+                return move;
+        }
+
+        this->index = this->bad_captures;
+        this->stage = BAD_CAPTURES_STAGE;
+        // Fall through
+
+    case BAD_CAPTURES_STAGE:
+        while (this->index < this->end_captures) {
+            move = actions.pick(this->index, this->end_captures);
+            this->index++;
+
+            if (move != this->hash_move)
+                return move;
+        }
+
+        this->stage = DONE_STAGE;
+        return 0;
+
+    case GENERATE_EVASIONS_STAGE:
+        actions.clear();
+        // The legal generator already keeps to the check mask, so every move is an evasion
+        board.actions(actions);
+        this->score_evasions();
+        this->index = 0;
+        this->stage = EVASIONS_STAGE;
+        // Fall through
+
+    case EVASIONS_STAGE:
+        while (this->index < actions.size()) {
+            move = actions.pick(this->index++);
+
+            if (move != this->hash_move)
+                return move;
+        }
+
+        this->stage = DONE_STAGE;
+        return 0;
+
+    default: // DONE_STAGE
+        return 0;
+    }
+}
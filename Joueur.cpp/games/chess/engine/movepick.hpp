@@ -0,0 +1,40 @@
+#ifndef MOVEPICK_HPP
+#define MOVEPICK_HPP
+
+#include "constants.hpp"
+#include "movelist.hpp"
+#include "state.hpp"
+
+// Hands out the moves of the current position best first, one PickerStages stage at a time:
+// the hash move, the captures & promotions that don't lose material, the killers, the
+// countermove, the other quiet moves by history, then the losing captures. Later stages are
+// only generated once the earlier ones are used up, so a node that cuts off early never pays
+// for generating (or scoring) its quiet moves
+// The generated moves are kept in the current frame's actions
+class MovePicker {
+private:
+    State *state;
+    MoveList *actions;
+    int stage;
+    int hash_move;
+    int killers[NUM_KILLERS];
+    int counter;
+    int index;        // Next move of the current stage
+    int end_captures; // Captures & promotions are actions [0, end_captures), the quiet moves follow
+    int bad_captures; // First capture left for the bad captures stage
+    bool in_check;
+    bool quiescence;  // Stop after the good captures
+
+    bool is_killer(int move) const;
+    bool is_refutation(int move) const;
+    void score_captures(void);
+    void score_quiets(void);
+    void score_evasions(void);
+
+public:
+    MovePicker(State &state, int hash_move, bool in_check);
+    MovePicker(State &state, bool in_check);
+    int next_move(void);
+};
+
+#endif // MOVEPICK_HPP
@@ -0,0 +1,219 @@
+#include "perft.hpp"
+
+// Standard positions with published node counts
+// The edge case positions each exercise one rule (en passant pins, castling through check,
+// promotions out of check, ...) at a depth deep enough for a wrong rule to change the count
+const std::vector<PerftPosition> PERFT_SUITE = {
+    {"startpos", START_FEN, 5, 4865609},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603},
+    {"position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6, 11030083},
+    {"position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5, 15833292},
+    {"position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487},
+    {"position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594},
+    {"illegal en passant (rank pin)", "3k4/3p4/8/K1P4r/8/8/8/8 b - - 0 1", 6, 1134888},
+    {"illegal en passant (diagonal pin)", "8/8/4k3/8/2p5/8/B2P2K1/8 w - - 0 1", 6, 1015133},
+    {"en passant gives check", "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1", 6, 1440467},
+    {"short castling gives check", "5k2/8/8/8/8/8/8/4K2R w K - 0 1", 6, 661072},
+    {"long castling gives check", "3k4/8/8/8/8/8/8/R3K3 w Q - 0 1", 6, 803711},
+    {"castling rights", "r3k2r/1b4bq/8/8/8/8/7B/R3K2R w KQkq - 0 1", 4, 1274206},
+    {"castling prevented", "r3k2r/8/3Q4/8/8/5q2/8/R3K2R b KQkq - 0 1", 4, 1720476},
+    {"promote out of check", "2K2r2/4P3/8/8/8/8/8/3k4 w - - 0 1", 6, 3821001},
+    {"discovered check", "8/8/1P2K3/8/2n5/1q6/8/5k2 b - - 0 1", 5, 1004658},
+    {"promote to give check", "4k3/1P6/8/8/8/8/K7/8 w - - 0 1", 6, 217342},
+    {"underpromote to check", "8/P1k5/K7/8/8/8/8/8 w - - 0 1", 6, 92683},
+    {"self stalemate", "K1k5/8/P7/8/8/8/8/8 w - - 0 1", 6, 2217},
+    {"stalemate & checkmate", "8/k1P5/8/1K6/8/8/8/8 w - - 0 1", 7, 567584},
+    {"double check", "8/8/2k5/5q2/5n2/8/5K2/8 b - - 0 1", 4, 23527},
+};
+
+// Mixed into keys so one position's counts at different depths land in different entries
+constexpr U64 PERFT_DEPTH_SALT = 0x9E3779B97F4A7C15;
+
+// Allocates the largest power of two number of entries that fits in megabytes
+PerftHash::PerftHash(int megabytes) {
+    size_t num_entries = 1;
+    while (num_entries * 2 * sizeof(Entry) <= (size_t)megabytes << 20)
+        num_entries *= 2;
+
+    this->entries = std::vector<Entry>(num_entries);
+    this->index_mask = num_entries - 1;
+}
+
+// Sets nodes and returns true if the count for key at depth is stored
+bool PerftHash::probe(U64 key, int depth, U64 &nodes) const {
+    key ^= depth * PERFT_DEPTH_SALT;
+    const Entry &entry = this->entries[key & this->index_mask];
+    U64 data = entry.data.load(std::memory_order_relaxed);
+    U64 check = entry.check.load(std::memory_order_relaxed);
+
+    if ((check ^ data) != key || (int)(data & 0xFF) != depth)
+        return false;
+
+    nodes = data >> 8;
+    return true;
+}
+
+// Stores the count for key at depth, always replacing what was there
+void PerftHash::store(U64 key, int depth, U64 nodes) {
+    key ^= depth * PERFT_DEPTH_SALT;
+    Entry &entry = this->entries[key & this->index_mask];
+    U64 data = (nodes << 8) | (U64)depth;
+
+    entry.data.store(data, std::memory_order_relaxed);
+    entry.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+// Returns the number of leaf nodes depth plies below board
+// With bulk set the last ply is counted from the move list without being made
+U64 perft(ChessBoard &board, int depth, bool bulk, PerftHash *hash) {
+    if (depth == 0)
+        return 1;
+
+    U64 key = board.key;
+    U64 nodes = 0;
+
+    // Subtrees one ply deep are cheaper to count than to look up
+    bool use_hash = hash != NULL && depth > 1;
+    if (use_hash && hash->probe(key, depth, nodes))
+        return nodes;
+
+    MoveList moves;
+    UndoInfo undo;
+
+    board.actions(moves);
+
+    if (bulk && depth == 1)
+        return moves.size();
+
+    for (int i = 0; i < moves.size(); i++) {
+        board.make_move(moves[i], undo);
+        nodes += perft(board, depth - 1, bulk, hash);
+        board.unmake_move(moves[i], undo);
+    }
+
+    if (use_hash)
+        hash->store(key, depth, nodes);
+
+    return nodes;
+}
+
+// One unit of work for perft_parallel: a line of moves from the root and its subtree count
+struct PerftWork {
+    int root;     // Index of the line's root move
+    int moves[2];
+    int length;
+    U64 nodes;
+};
+
+// perft() split across options.threads workers
+// Workers pull lines one or two plies deep from a shared counter and count below them
+U64 perft_parallel(const ChessBoard &board, int depth, const PerftOptions &options) {
+    if (depth == 0)
+        return 1;
+
+    ChessBoard root = board;
+    MoveList root_moves;
+    MoveList replies;
+    UndoInfo undo;
+    std::vector<PerftWork> work;
+
+    root.actions(root_moves);
+
+    // Splitting below the second ply keeps workers busy when there are few root moves
+    bool split_replies = options.threads > 1 && depth >= 3;
+
+    for (int r = 0; r < root_moves.size(); r++) {
+        PerftWork line = {r, {root_moves[r], 0}, 1, 0};
+
+        if (!split_replies) {
+            work.push_back(line);
+            continue;
+        }
+
+        root.make_move(root_moves[r], undo);
+        replies.clear();
+        root.actions(replies);
+        root.unmake_move(root_moves[r], undo);
+
+        line.length = 2;
+        for (int i = 0; i < replies.size(); i++) {
+            line.moves[1] = replies[i];
+            work.push_back(line);
+        }
+    }
+
+    std::unique_ptr<PerftHash> hash(options.hash_mb > 0 ? new PerftHash(options.hash_mb) : NULL);
+    std::atomic<size_t> next_work(0);
+
+    auto worker = [&]() {
+        ChessBoard line_board;
+        UndoInfo line_undo;
+        size_t w;
+
+        while ((w = next_work++) < work.size()) {
+            line_board = board;
+
+            for (int m = 0; m < work[w].length; m++)
+                line_board.make_move(work[w].moves[m], line_undo);
+
+            work[w].nodes = perft(line_board, depth - work[w].length, options.bulk, hash.get());
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 1; t < options.threads; t++)
+        threads.push_back(std::thread(worker));
+
+    worker();
+
+    for (size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+
+    std::vector<U64> root_nodes(root_moves.size(), 0);
+    U64 nodes = 0;
+
+    for (size_t w = 0; w < work.size(); w++) {
+        root_nodes[work[w].root] += work[w].nodes;
+        nodes += work[w].nodes;
+    }
+
+    if (options.divide) {
+        for (int r = 0; r < root_moves.size(); r++)
+            std::cout << get_move_str(root_moves[r]) << ": " << root_nodes[r] << std::endl;
+    }
+
+    return nodes;
+}
+
+// Runs perft on every PERFT_SUITE position, printing counts & speed
+// Returns true if every count matched
+bool run_perft_suite(const PerftOptions &options) {
+    bool passed = true;
+    U64 total_nodes = 0;
+    double total_ns = 0;
+
+    for (size_t p = 0; p < PERFT_SUITE.size(); p++) {
+        const PerftPosition &position = PERFT_SUITE[p];
+        ChessBoard board(position.fen);
+
+        double start = GET_TIME_NS();
+        U64 nodes = perft_parallel(board, position.depth, options);
+        double elapsed = GET_TIME_NS() - start;
+
+        total_nodes += nodes;
+        total_ns += elapsed;
+
+        bool matched = nodes == position.nodes;
+        passed &= matched;
+
+        std::cout << (matched ? "ok   " : "FAIL ") << position.name << " (depth " << position.depth << "): " << nodes;
+        if (!matched)
+            std::cout << ", expected " << position.nodes;
+        std::cout << " [" << (U64)(nodes / (elapsed / 1e9)) << " nps]" << std::endl;
+    }
+
+    std::cout << "total: " << total_nodes << " nodes in " << total_ns / 1e9 << " s ["
+              << (U64)(total_nodes / (total_ns / 1e9)) << " nps]" << std::endl;
+
+    return passed;
+}
@@ -0,0 +1,56 @@
+#ifndef PERFT_HPP
+#define PERFT_HPP
+
+#include "chessboard.hpp"
+#include "constants.hpp"
+#include "movelist.hpp"
+#include "util.hpp"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+const std::string START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// A position with a known perft node count at depth
+struct PerftPosition {
+    std::string name;
+    std::string fen;
+    int depth;
+    U64 nodes;
+};
+
+extern const std::vector<PerftPosition> PERFT_SUITE;
+
+struct PerftOptions {
+    int threads = 1;     // Worker threads the first plies are split across
+    int hash_mb = 0;     // Size of the shared subtree count table, 0 to disable
+    bool bulk = false;   // Count the moves at depth 1 instead of making them
+    bool divide = false; // Print the count below each root move
+};
+
+// Shared table of subtree counts keyed by position & depth
+// Entries are two relaxed atomics with the key XORed into the check word, so a
+// torn read from a racing store fails validation and is treated as a miss
+class PerftHash {
+private:
+    struct Entry {
+        std::atomic<U64> check; // key ^ data
+        std::atomic<U64> data;  // nodes << 8 | depth
+    };
+
+    std::vector<Entry> entries;
+    U64 index_mask;
+
+public:
+    PerftHash(int megabytes);
+    bool probe(U64 key, int depth, U64 &nodes) const;
+    void store(U64 key, int depth, U64 nodes);
+};
+
+U64 perft(ChessBoard &board, int depth, bool bulk = false, PerftHash *hash = NULL);
+U64 perft_parallel(const ChessBoard &board, int depth, const PerftOptions &options);
+bool run_perft_suite(const PerftOptions &options);
+
+#endif // PERFT_HPP
@@ -0,0 +1,79 @@
+// Standalone perft driver for the move generator
+//
+// Usage:
+//   perft [options]                          run the reference suite
+//   perft [options] <depth> [fen]            count leaf nodes from fen (startpos by default)
+//   perft [options] divide <depth> [fen]     same, with the count below each root move
+//
+// Options:
+//   -t <threads>   split the first plies across this many threads
+//   -H <mb>        share a subtree count table of this size between threads
+//   -b             bulk count the last ply
+
+#include "chessboard.hpp"
+#include "magic.hpp"
+#include "perft.hpp"
+#include "util.hpp"
+#include <iostream>
+#include <string>
+
+int main(int argc, char *argv[]) {
+    if (!verify_magic_attacks(1000)) {
+        std::cerr << "Magic bitboard attacks don't match ray attacks" << std::endl;
+        return 1;
+    }
+
+    PerftOptions options;
+    int arg = 1;
+
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        std::string flag = argv[arg];
+
+        if (flag == "-b") {
+            options.bulk = true;
+        }
+        else if (flag == "-t" && arg + 1 < argc) {
+            options.threads = std::max(1, atoi(argv[++arg]));
+        }
+        else if (flag == "-H" && arg + 1 < argc) {
+            options.hash_mb = std::max(0, atoi(argv[++arg]));
+        }
+        else {
+            std::cerr << "usage: " << argv[0] << " [-t threads] [-H mb] [-b] [divide] <depth> [fen]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (arg >= argc)
+        return run_perft_suite(options) ? 0 : 1;
+
+    options.divide = std::string(argv[arg]) == "divide";
+    if (options.divide)
+        arg++;
+
+    if (arg >= argc) {
+        std::cerr << "usage: " << argv[0] << " [-t threads] [-H mb] [-b] [divide] <depth> [fen]" << std::endl;
+        return 1;
+    }
+
+    int depth = atoi(argv[arg++]);
+
+    // The FEN may be passed as one argument or split on its spaces
+    std::string fen = "";
+    for (; arg < argc; arg++)
+        fen += (fen.empty() ? "" : " ") + std::string(argv[arg]);
+    if (fen.empty())
+        fen = START_FEN;
+
+    ChessBoard board(fen);
+
+    double start = GET_TIME_NS();
+    U64 nodes = perft_parallel(board, depth, options);
+    double elapsed = GET_TIME_NS() - start;
+
+    std::cout << "nodes: " << nodes << std::endl;
+    std::cout << "time: " << elapsed / 1e9 << " s" << std::endl;
+    std::cout << "nps: " << (U64)(nodes / (elapsed / 1e9)) << std::endl;
+
+    return 0;
+}
@@ -1,44 +1,49 @@
 #include "chessboard.hpp"
 #include "constants.hpp"
+#include "movepick.hpp"
 #include "search.hpp"
 #include "state.hpp"
+#include "transposition.hpp"
 #include "util.hpp"
+#include "ybwc.hpp"
 #include <algorithm>
-#include <unordered_map>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+// Returns true if the current position is drawn by the 50 move rule, 3-fold repetition or insufficient material
+// Checkmate on the 100th half move still counts, so in_check positions are looked at for an evasion first
+static bool drawn(State &state, bool in_check) {
+    // 100 half moves = 50 moves (50 move rule)
+    if (state.board.half_moves >= 100) {
+        if (!in_check)
+            return true;
+
+        // In check, so these are the evasions
+        state.generate_actions();
+        return !state.frame().actions.empty();
+    }
 
-std::unordered_map<int, int> dummy_map = {{0,0}};
+    return state.check_3_fold_rep() || state.insufficient_material();
+}
 
-// Returns the terminal node type if state is a terminal node, INTERNAL_NODE otherwise.
-int terminal_test(State state, std::vector<int> move_history) {
+// Returns the terminal node type if state's current position is a terminal node, INTERNAL_NODE otherwise.
+// The current frame's actions must already be generated
+int terminal_test(State &state) {
     if (state.board.stalemate)
         return DRAW_TERMINAL_NODE;
 
-    if (!state.actions.size()) {
+    if (state.frame().actions.empty()) {
         // Checkmate
         return LOSE_TERMINAL_NODE;
     }
 
-    if (state.board.half_moves == 100) {
-        // 100 half moves = 50 moves (50 move rule)
-        return DRAW_TERMINAL_NODE;
-    }
-
-    if (state.board.half_moves == 8 && state.check_3_fold_rep(move_history)) {
-        // 3-fold repetition
+    // Checkmate is ruled out already
+    if (drawn(state, false))
         return DRAW_TERMINAL_NODE;
-    }
 
-    if (state.insufficient_material()) {
-        return DRAW_TERMINAL_NODE;
-    }
-
-    if (state.depth <= 0) {
-        if (!state.is_quiescent && state.qs_depth > 0) {
-            // Continue with quiescent search
-            return INTERNAL_NODE;
-        }
-
-        // No more regular depth or quiescent depth to exhaust
+    if (state.ply >= MAX_PLY) {
+        // The search stack is full
         return DEPTH_LIMIT_REACHED;
     }
 
@@ -46,362 +51,570 @@ int terminal_test(State state, std::vector<int> move_history) {
     return INTERNAL_NODE;
 }
 
-// Depth-Limited MiniMax where the current depth is encoded (and decremented) 
-// as part of the State class.
-// Returns an action. 
-int depth_limited_minimax(State initial_state, std::vector<int> history) {
-    // Return the action with maximum utility value
-    int best_action;
-    int best_value = MIN_VALUE;    
-    int curr_value;
-    
-    for (int a = 0; a < initial_state.actions.size(); a++) {
-        curr_value = min_value(initial_state.result(initial_state.actions[a]), history);
-        
-        if (curr_value >= best_value) {
-            best_value = curr_value;
-            best_action = initial_state.actions[a];
-        }
-    }
-    
-    return best_action;
+// Returns the utility of the current position for terminal_result from the point of view of its side to move
+// utility() scores for the max player, negamax scores for the side to move
+static inline int negamax_utility(State &state, int terminal_result) {
+    int utility = state.utility(terminal_result);
+    return (state.board.color == state.max_player_color) ? utility : -utility;
 }
 
-// Returns a utility value
-int max_value(State state, std::vector<int> history) {
-    int terminal_result = terminal_test(state, history);
+std::atomic<bool> search_stopped(false);
+std::atomic<bool> search_pondering(false);
 
-    if (terminal_result != INTERNAL_NODE) {
-        // This is a terminal node
-        return state.utility(terminal_result);
-    }
+// Stops the search if limits' deadline has passed, returning true if the search is stopped
+// While pondering, the limits may still be written by a ponder hit, so they're only read once it's over
+bool check_limits(const SearchLimits &limits) {
+    if (!search_pondering.load(std::memory_order_acquire) && limits.end_time && GET_TIME_NS() > limits.end_time)
+        search_stopped = true;
 
-    int value = MIN_VALUE;
+    return search_stopped.load(std::memory_order_relaxed);
+}
+
+// Returns true if state's search has been stopped or made pointless by a cutoff on another thread
+static inline bool search_aborted(const State &state) {
+    return search_stopped.load(std::memory_order_relaxed) || cutoff_occurred(state.split);
+}
 
-    for (int a = 0; a < state.actions.size(); a++) {
-        history.push_back(state.actions[a]);
-        value = std::max(value, min_value(state.result(state.actions[a]), history));
-        history.pop_back();
+// Returns true if a stored entry already settles the current position's value for the
+// (alpha, beta) window, setting value to it. Sets hash_move to the entry's best move either way
+// Scores are from the point of view of the side to move
+bool tt_cutoff(State &state, int depth, int alpha, int beta, int &value, int &hash_move) {
+    TTEntry entry;
+    hash_move = 0;
+
+    // Quiescence nodes are never stored, so don't bother looking them up
+    if (depth <= 0)
+        return false;
+
+    state.tt_probes++;
+    if (!TT.probe(state.board.key, entry))
+        return false;
+
+    state.tt_hits++;
+    hash_move = entry.move;
+
+    // Entries only apply when searched at least as deep
+    if (entry.depth < depth)
+        return false;
+
+    if (entry.bound == TT_EXACT ||
+        (entry.bound == TT_LOWER && entry.score >= beta) ||
+        (entry.bound == TT_UPPER && entry.score <= alpha)) {
+        value = entry.score;
+        return true;
     }
 
-    return value;
+    return false;
 }
 
-int min_value(State state, std::vector<int> history) {
-    int terminal_result = terminal_test(state, history);
+// Stores the current position's value as searched to depth with the (alpha, beta) window
+void tt_store(const State &state, int depth, int alpha, int beta, int value, int best_action) {
+    if (depth <= 0)
+        // Quiescence results depend on the path into them
+        return;
 
-    if (terminal_result != INTERNAL_NODE) {
-        // This is a terminal node
-        return state.utility(terminal_result);
-    }
+    int bound = (value <= alpha) ? TT_UPPER : (value >= beta) ? TT_LOWER : TT_EXACT;
+    TT.store(state.board.key, depth, value, bound, best_action);
+}
 
-    int value = MAX_VALUE;
+// Moves entry toward +/- HISTORY_MAX by bonus, by less the closer it already is
+static inline void update_history(int &entry, int bonus) {
+    entry += bonus - entry * std::abs(bonus) / HISTORY_MAX;
+}
 
-    for (int a = 0; a < state.actions.size(); a++) {
-        history.push_back(state.actions[a]);
-        value = std::min(value, max_value(state.result(state.actions[a]), history));
-        history.pop_back();
-    }
+// Applies bonus to quiet move's history, following on from the earlier moves whose continuation tables aren't NULL
+static inline void update_history_score(ButterflyTable &history, PieceToTable *const continuations[], int move, bool color, int bonus) {
+    int piece = get_piece_index(move);
+    int to = get_to_square(move, color);
+    update_history(history[get_from_square(move, color)][to], bonus);
 
-    return value;
+    for (int i = 0; i < CONTINUATION_PLIES; i++) {
+        if (continuations[i])
+            update_history((*continuations[i])[piece][to], bonus);
+    }
 }
 
-// Returns an action
-int iterative_deepening_depth_limited_minimax(std::string initial_fen, int max_depth_limit, bool max_player_color, std::vector<int> history) {
-    int action;    
+// Rewards quiet best_action for causing a cutoff at depth, making it a killer & countermove, and
+// penalizes the num_quiets quiet moves searched before it that failed to
+static void update_move_stats(State &state, int best_action, const int quiets[], int num_quiets, int depth) {
+    SearchFrame &frame = state.frame();
+    bool color = state.board.color;
+    ButterflyTable &history = state.history[color];
+    PieceToTable *continuations[CONTINUATION_PLIES];
+
+    for (int i = 0; i < CONTINUATION_PLIES; i++)
+        continuations[i] = state.continuation(i + 1);
+
+    // Quiescence cutoffs count as depth 1
+    int bonus = std::min(std::max(depth, 1) * std::max(depth, 1), HISTORY_MAX);
 
-    for (int depth_limit = 1; depth_limit <= max_depth_limit; depth_limit++) {
-        print("Depth" + std::to_string(depth_limit));
-        action = depth_limited_minimax(State(ChessBoard(initial_fen), depth_limit, 0, max_player_color), history);
+    if (frame.killers[0] != best_action) {
+        frame.killers[1] = frame.killers[0];
+        frame.killers[0] = best_action;
     }
 
-    print();
+    int *countermove = state.countermove();
+    if (countermove)
+        *countermove = best_action;
 
-    return action;
+    update_history_score(history, continuations, best_action, color, bonus);
+
+    for (int i = 0; i < num_quiets; i++)
+        update_history_score(history, continuations, quiets[i], color, -bonus);
 }
 
-// Time-Limited Iterative-Deepening Depth-Limited MiniMax with alpha-beta pruning max value. Returns a utility value
-int tliddlmmwabp_max_value(State state, int alpha, int beta, std::vector<int> history) {
-    int terminal_result = terminal_test(state, history);
+// Searches action from the current position, returning its value for the side to move
+int search_action(State &state, int action, int depth, int alpha, int beta) {
+    state.make_move(action);
+    int value = -principal_variation_search(state, depth - 1, -beta, -alpha);
+    state.unmake_move();
 
-    if (terminal_result != INTERNAL_NODE) {
-        // This is a terminal node
-        return state.utility(terminal_result);
-    }
-    
-    int value = MIN_VALUE;
-    
-    for (auto &action : state.actions) {
-        history.push_back(action);
-        value = std::max(value, tliddlmmwabp_min_value(state.result(action), alpha, beta, history));
-        history.pop_back();
-        
-        if (value >= beta)
-            // Fail high, prune
-            return value;
-        
-        alpha = std::max(alpha, value);
-    }
-    
     return value;
 }
 
-// Time-Limited Iterative-Deepening Depth-Limited MiniMax with alpha-beta pruning min value. Returns a utility value
-int tliddlmmwabp_min_value(State state, int alpha, int beta, std::vector<int> history) {
-    int terminal_result = terminal_test(state, history);
+// Null move pruning: if the side to move could pass and a reduced null window search still fails
+// high, any real move is expected to as well, so the node fails high without searching one
+// Passing is only tried at null window nodes not in check, where the static evaluation is already at
+// least beta, the last move wasn't a pass and the side to move has more than its king & pawns (with
+// only those, zugzwang makes passing the best move too often). Cutoffs from NULL_MOVE_VERIFY_DEPTH on
+// are verified by a reduced search of the node itself with passing disabled for the side to move
+// Returns true if the node can be pruned, setting value to its result
+bool null_move_cutoff(State &state, int depth, int alpha, int beta, bool in_check, int &value) {
+    if (beta - alpha != 1 || in_check || depth < NULL_MOVE_MIN_DEPTH || !state.ply || !state.frames[state.ply - 1].current_move ||
+        !state.board.has_non_pawn_material(state.board.color) || !state.null_move_allowed())
+        return false;
 
-    if (terminal_result != INTERNAL_NODE) {
-        // This is a terminal node
-        return state.utility(terminal_result);
-    }
-    
-    int value = MAX_VALUE;
-    
-    for (auto &action : state.actions) {
-        history.push_back(action);
-        value = std::min(value, tliddlmmwabp_max_value(state.result(action), alpha, beta, history));
-        history.pop_back();
-
-        if (value <= alpha)
-            // Fail low, prune
-            return value;
-        
-        beta = std::min(beta, value);
+    int static_eval = negamax_utility(state, DEPTH_LIMIT_REACHED);
+    state.frame().static_eval = static_eval;
+
+    if (static_eval < beta)
+        return false;
+
+    int reduction = NULL_MOVE_REDUCTION + depth / NULL_MOVE_DEPTH_DIVISOR;
+    state.null_moves++;
+
+    state.make_null_move();
+    int null_value = -principal_variation_search(state, depth - 1 - reduction, -beta, -beta + 1);
+    state.unmake_null_move();
+
+    if (search_aborted(state) || null_value < beta)
+        return false;
+
+    // A mate found after passing isn't proven
+    if (null_value >= MAX_VALUE)
+        null_value = beta;
+
+    if (depth >= NULL_MOVE_VERIFY_DEPTH && !state.null_move_min_ply) {
+        // Search on without passing until most of the way down the reduced depth
+        state.null_move_min_ply = state.ply + 3 * (depth - reduction) / 4;
+        state.null_move_color = state.board.color;
+
+        int verified = principal_variation_search(state, depth - reduction, beta - 1, beta);
+        state.null_move_min_ply = 0;
+
+        if (search_aborted(state) || verified < beta)
+            return false;
     }
-    
-    return value;
+
+    state.null_cutoffs++;
+    value = null_value;
+    return true;
 }
 
-// Returns an action
-int time_limited_iterative_deepening_depth_limited_minimax_with_alpha_beta_pruning(std::string initial_fen, bool max_player_color, std::vector<int> history, double time_remaining_ns) {
-    int value = MIN_VALUE;
-    int best_value = MIN_VALUE;
-    int best_action = 0;
-    int prev_depth_best_action = 0;
-    int alpha;
-    int beta;
-    int terminal_result;
+// Quiescence search: plays out captures & promotions from a leaf until the position is quiet,
+// so the static evaluation is never taken halfway through an exchange
+// The side to move can stand pat on the static evaluation rather than capture, unless it's
+// in check, where every evasion is searched instead
+// Returns the current position's value from the point of view of its side to move
+int quiescence_search(State &state, int alpha, int beta) {
+    if (search_aborted(state))
+        return ABORTED_VALUE;
 
-    // Determine allocated time for this move
-    double end_time = GET_TIME_NS() + (time_remaining_ns / ESTIMATED_REMAINING_MOVES);
+    if ((++state.nodes & (TIME_CHECK_NODES - 1)) == 0 && state.limits && check_limits(*state.limits))
+        return ABORTED_VALUE;
 
-    int depth_limit = 1;
-    while (true) {
-        print("Depth" + std::to_string(depth_limit));
+    bool in_check = state.board.update_in_check();
 
-        State state = State(ChessBoard(initial_fen), depth_limit, 0, max_player_color);
-        terminal_result = terminal_test(state, history);
+    if (drawn(state, in_check))
+        return negamax_utility(state, DRAW_TERMINAL_NODE);
 
-        // Return this state's action with value found from the max value function
-        if (terminal_result != INTERNAL_NODE) {
-            // The search cannot start in a terminal node
-            print("The search cannot start in a terminal node.");
-            return 0;
-        } else {
-            alpha = INIT_ALPHA;
-            beta  = INIT_BETA;
+    int stand_pat = negamax_utility(state, DEPTH_LIMIT_REACHED);
+    state.frame().static_eval = stand_pat;
 
-            for (auto &action : state.actions) {
-                history.push_back(action);
-                value = tliddlmmwabp_min_value(state.result(action), alpha, beta, history);
-                history.pop_back();
-
-                if (value > best_value) {
-                    best_value = value;
-                    best_action = action;
-                }
-                
-                if (value >= beta)
-                    // Fail high, prune
-                    return action;
-                
-                alpha = std::max(alpha, value);
-                
-                // Check for timeout
-                if (GET_TIME_NS() > (end_time)) {
-                    print("TIMEOUT");
-                    return prev_depth_best_action;
-                }
-            }
-        }
+    if (state.ply >= MAX_PLY)
+        // The search stack is full
+        return stand_pat;
 
-        prev_depth_best_action = best_action;
-        depth_limit++;
+    int value = in_check ? MIN_VALUE : stand_pat;
+
+    if (value >= beta)
+        // Standing pat is already too good, the opponent won't allow it
+        return value;
+
+    alpha = std::max(alpha, value);
+
+    // SEE pruning: the picker stops before the losing captures
+    MovePicker picker(state, in_check);
+    int action;
+    int searched = 0;
+
+    while ((action = picker.next_move())) {
+        searched++;
+
+        if (!in_check && stand_pat + state.board.capture_gain(action) + QS_DELTA_MARGIN <= alpha)
+            // Delta pruning: even winning the material outright can't raise alpha
+            continue;
+
+        state.make_move(action);
+        int new_value = -quiescence_search(state, -beta, -alpha);
+        state.unmake_move();
+
+        if (search_aborted(state))
+            return ABORTED_VALUE;
+
+        value = std::max(value, new_value);
+        alpha = std::max(alpha, value);
+
+        if (alpha >= beta)
+            // Fail high, prune
+            break;
     }
-    
-    print();
-    
-    return best_action;
+
+    if (in_check && !searched)
+        // Checkmate
+        return negamax_utility(state, LOSE_TERMINAL_NODE);
+
+    return value;
 }
 
-// Time-Limited Iterative-Deepening Depth-Limited MiniMax with alpha-beta pruning and Quiescence Search and History Table
-// Returns a utility value
-int tliddlmabpqsht_max_value(State state, int alpha, int beta, std::vector<int> move_history, std::unordered_map<int, int> &history_table) {
-    int terminal_result = terminal_test(state, move_history);
+// Negamax principal variation search
+// Returns the current position's value from the point of view of its side to move
+// The first move is searched with the full (alpha, beta) window. Every later move is
+// expected to be worse, which a null window around alpha proves cheaply; a move that
+// beats alpha anyway is searched again with the full window to get its exact value
+int principal_variation_search(State &state, int depth, int alpha, int beta) {
+    if (depth <= 0)
+        return quiescence_search(state, alpha, beta);
+
+    if (search_aborted(state))
+        return ABORTED_VALUE;
+
+    // Poll the clock every so often so a deep subtree can't run past the deadline
+    if ((++state.nodes & (TIME_CHECK_NODES - 1)) == 0 && state.limits && check_limits(*state.limits))
+        return ABORTED_VALUE;
+
+    bool in_check = state.board.update_in_check();
+
+    if (drawn(state, in_check))
+        return negamax_utility(state, DRAW_TERMINAL_NODE);
+
+    if (state.ply >= MAX_PLY)
+        // The search stack is full
+        return negamax_utility(state, DEPTH_LIMIT_REACHED);
 
-    if (terminal_result != INTERNAL_NODE) {
-        // This is a terminal node
-        return state.utility(terminal_result);
-    }
-    
     int value = MIN_VALUE;
     int best_action = 0;
     int new_value;
+    int hash_move;
+    int action;
+    int searched = 0;
+    int quiets[MAX_QUIETS_SEARCHED]; // Searched without a cutoff
+    int num_quiets = 0;
+    int alpha_orig = alpha;
+
+    if (tt_cutoff(state, depth, alpha, beta, value, hash_move))
+        return value;
+
+    if (null_move_cutoff(state, depth, alpha, beta, in_check, value))
+        return value;
+
+    if (search_aborted(state))
+        return ABORTED_VALUE;
+
+    MovePicker picker(state, hash_move, in_check);
+
+    while ((action = picker.next_move())) {
+        searched++;
+
+        if (searched == 1) {
+            new_value = search_action(state, action, depth, alpha, beta);
+        }
+        else {
+            new_value = search_action(state, action, depth, alpha, alpha + 1);
+
+            if (new_value > alpha && new_value < beta)
+                // The null window failed high, get the exact value
+                new_value = search_action(state, action, depth, alpha, beta);
+        }
+
+        if (search_aborted(state))
+            // Unwind, new_value is meaningless
+            return ABORTED_VALUE;
 
-    state.actions = ht_sort(state.actions, history_table);
-    
-    for (auto &action : state.actions) {
-        move_history.push_back(action);
-        new_value = tliddlmabpqsht_min_value(state.result(action), alpha, beta, move_history, history_table);
-        move_history.pop_back();
-        
-        // Get the new max value and best action
         if (new_value > value) {
             value = new_value;
             best_action = action;
         }
 
-        if (value >= beta) {
+        alpha = std::max(alpha, value);
+
+        if (alpha >= beta)
             // Fail high, prune
+            break;
 
-            // Update the history table
-            if (ht_contains(history_table, action))
-                history_table[action]++;
-            else
-                history_table[action] = 1;
+        if (is_quiet(action) && num_quiets < MAX_QUIETS_SEARCHED)
+            quiets[num_quiets++] = action;
 
-            return value;
+        if (searched == 1 && ybwc_can_split(state, depth)) {
+            // The eldest brother is done, the younger ones can be searched in parallel
+            ybwc_split(state, picker, depth, alpha, beta, value, best_action);
+            break;
         }
-        
-        alpha = std::max(alpha, value);
     }
-    
-    // Update the history table
-    if (ht_contains(history_table, best_action))
-        history_table[best_action]++;
-    else
-        history_table[best_action] = 1;
+
+    if (search_aborted(state))
+        // value is incomplete, don't keep it
+        return ABORTED_VALUE;
+
+    if (!searched)
+        // Checkmate or stalemate
+        return negamax_utility(state, in_check ? LOSE_TERMINAL_NODE : DRAW_TERMINAL_NODE);
+
+    if (value >= beta && best_action && is_quiet(best_action))
+        update_move_stats(state, best_action, quiets, num_quiets, depth);
+
+    tt_store(state, depth, alpha_orig, beta, value, best_action);
 
     return value;
 }
 
-// Time-Limited Iterative-Deepening Depth-Limited MiniMax with alpha-beta pruning and Quiescence Search and History Table
-// Returns a utility value
-int tliddlmabpqsht_min_value(State state, int alpha, int beta, std::vector<int> move_history, std::unordered_map<int, int> &history_table) {
-    int terminal_result = terminal_test(state, move_history);
+// Searches every root action to depth with the (alpha, beta) window, setting best_action
+// Returns the best value, ABORTED_VALUE if the search was stopped
+int search_root(State &state, int depth, int alpha, int beta, int &best_action, const SearchLimits &limits) {
+    MoveList &actions = state.frame().actions;
+    int value;
+    int best_value = INIT_ALPHA;
 
-    if (terminal_result != INTERNAL_NODE) {
-        // This is a terminal node
-        return state.utility(terminal_result);
-    }
+    for (int i = 0; i < actions.size(); i++) {
+        int action = actions[i];
 
-    int value = MAX_VALUE;
-    int best_action = 0;
-    int new_value;
-    
-    state.actions = ht_sort(state.actions, history_table);
+        if (i == 0) {
+            value = search_action(state, action, depth, alpha, beta);
+        }
+        else {
+            value = search_action(state, action, depth, alpha, alpha + 1);
 
-    for (auto &action : state.actions) {
-        move_history.push_back(action);
-        new_value = tliddlmabpqsht_max_value(state.result(action), alpha, beta, move_history, history_table);
-        move_history.pop_back();
+            if (value > alpha && value < beta)
+                value = search_action(state, action, depth, alpha, beta);
+        }
 
-        // Get the new min value and best action
-        if (new_value < value) {
-            value = new_value;
+        if (search_stopped.load(std::memory_order_relaxed))
+            return ABORTED_VALUE;
+
+        if (value > best_value) {
+            best_value = value;
             best_action = action;
         }
 
-        if (value <= alpha) {
-            // Fail low, prune
+        alpha = std::max(alpha, value);
 
-            // Update the history table
-            if (ht_contains(history_table, action))
-                history_table[action]++;
-            else
-                history_table[action] = 1;
+        if (alpha >= beta)
+            // Fail high, the window has to be widened anyway
+            break;
 
-            return value;
-        }
-        
-        beta = std::min(beta, value);
+        // Check for timeout
+        if (check_limits(limits))
+            return ABORTED_VALUE;
     }
 
-    // Update the history table
-    if (ht_contains(history_table, best_action))
-        history_table[best_action]++;
-    else
-        history_table[best_action] = 1;
-    
-    return value;
+    return best_value;
 }
 
-// Returns an action
-int time_limited_iterative_deepening_depth_limited_minimax_alpha_beta_pruning_quiescence_search_history_table(std::string initial_fen, bool max_player_color, std::vector<int> move_history, double time_remaining_ns) {
-    int value = MIN_VALUE;
-    int best_value = MIN_VALUE;
+// Iteratively deepens the search from start_depth until limits are reached or the search is stopped
+// Any thread can stop the search at the deadline (not while pondering), but only the main thread stops at limits.depth
+// Returns the best action of the last completed depth (or the best so far if none completed)
+int iterative_deepening(State &state, int start_depth, const SearchLimits &limits, bool is_main) {
+    int value;
+    int best_value = 0;
     int best_action = 0;
     int prev_depth_best_action = 0;
     int alpha;
     int beta;
+    int delta;
+    int researches;
     int terminal_result;
-    std::unordered_map<int, int> history_table;
-
-    // Determine allocated time for this move
-    double end_time = GET_TIME_NS() + (time_remaining_ns / ESTIMATED_REMAINING_MOVES);
+    int hash_move;
+    MoveList &actions = state.frame().actions;
 
-    int depth_limit = 1;
+    int depth_limit = start_depth;
     while (true) {
-        print("Depth" + std::to_string(depth_limit));
+        if (is_main && !limits.silent)
+            print("Depth" + std::to_string(depth_limit));
 
-        // NOTE: Depth information (both for regular and quiescent depth) is encoded in the State class
-        State state = State(ChessBoard(initial_fen), depth_limit, MAX_QS_DEPTH, max_player_color);
-        terminal_result = terminal_test(state, move_history);
+        state.generate_actions();
+        terminal_result = terminal_test(state);
 
         // Return this state's action with value found from the max value function
         if (terminal_result != INTERNAL_NODE) {
             // The search cannot start in a terminal node
-            print("The search cannot start in a terminal node.");
+            if (is_main && !limits.silent)
+                print("The search cannot start in a terminal node.");
             return 0;
-        } else {
+        }
+
+        // Start with the best move from the previous depth
+        tt_cutoff(state, depth_limit, INIT_ALPHA, INIT_BETA, value, hash_move);
+        actions.move_to_front(hash_move);
+
+        // Aspiration window: expect the score to stay near the previous depth's
+        delta = limits.aspiration_width;
+        if (prev_depth_best_action && delta) {
+            alpha = std::max(INIT_ALPHA, best_value - delta);
+            beta  = std::min(INIT_BETA, best_value + delta);
+        }
+        else {
             alpha = INIT_ALPHA;
             beta  = INIT_BETA;
+        }
 
-            for (auto &action : state.actions) {
-                move_history.push_back(action);
-                value = tliddlmabpqsht_min_value(state.result(action), alpha, beta, move_history, history_table);
-                move_history.pop_back();
-
-                if (value > best_value) {
-                    best_value = value;
-                    best_action = action;
-                }
-                
-                if (value >= beta)
-                    // Fail high, prune
-                    return action;
-                
-                alpha = std::max(alpha, value);
-                
-                // Check for timeout
-                if (GET_TIME_NS() > (end_time)) {
+        researches = 0;
+        while (true) {
+            value = search_root(state, depth_limit, alpha, beta, best_action, limits);
+
+            if (search_stopped.load(std::memory_order_relaxed)) {
+                if (is_main && !limits.silent)
                     print("TIMEOUT");
+
+                // The partial iteration is discarded unless nothing has completed
+                if (prev_depth_best_action)
                     return prev_depth_best_action;
-                }
+
+                return best_action ? best_action : actions[0];
+            }
+
+            if (value <= alpha) {
+                // Fail low, every move is worse than expected
+                alpha = std::max(INIT_ALPHA, value - delta);
+            }
+            else if (value >= beta) {
+                // Fail high, keep the move that did it first
+                beta = std::min(INIT_BETA, value + delta);
+                actions.move_to_front(best_action);
+            }
+            else {
+                break;
+            }
+
+            researches++;
+
+            // Widen the window, giving up on it once it's too wide to save anything
+            delta *= 2;
+            if (delta > ASPIRATION_MAX_WIDTH) {
+                alpha = INIT_ALPHA;
+                beta  = INIT_BETA;
             }
         }
 
+        best_value = value;
         prev_depth_best_action = best_action;
+        state.completed_depth = depth_limit;
+        state.researches += researches;
+
+        if (is_main && !limits.silent)
+            print("Score " + std::to_string(best_value) + ", re-searches " + std::to_string(researches));
 
-        // Update the history table
-        if (ht_contains(history_table, best_action))
-            history_table[best_action]++;
-        else
-            history_table[best_action] = 1;
+        TT.store(state.board.key, depth_limit, best_value, TT_EXACT, best_action);
+
+        if (is_main && limits.depth && depth_limit >= limits.depth && !search_pondering.load(std::memory_order_acquire))
+            return best_action;
+
+        // limits aren't final until pondering is over
+        if (is_main && !search_pondering.load(std::memory_order_acquire) && limits.time_manager &&
+            limits.time_manager->stop_iterating(best_action, best_value))
+            return best_action;
+
+        if (depth_limit >= MAX_PLY)
+            // Nothing deeper fits on the search stack
+            return best_action;
 
         depth_limit++;
     }
-    
-    // Just in case the while loop is broken out of
-    return best_action;
+}
+
+// Lazy SMP: every thread runs its own iterative deepening on the same position and
+// they only cooperate through the shared transposition table. Helpers start on
+// alternating depths so they tend to fill in entries ahead of the main thread
+// Returns the main thread's action
+int lazy_smp_search(const ChessBoard &board, bool max_player_color, const std::vector<U64> &key_history, const SearchLimits &limits, SearchStats *stats) {
+    int num_threads = std::max(1, limits.threads);
+
+    TT.new_search();
+
+    // Allocated once per thread, every depth searches in place on its state
+    std::vector<State> states(num_threads, State(board, max_player_color, key_history));
+    for (auto &state : states)
+        state.limits = &limits;
+    std::vector<std::thread> helpers;
+
+    for (int i = 1; i < num_threads; i++)
+        helpers.push_back(std::thread(iterative_deepening, std::ref(states[i]), 1 + i % 2, std::cref(limits), false));
+
+    int action = iterative_deepening(states[0], 1, limits, true);
+
+    search_stopped = true;
+    for (auto &helper : helpers)
+        helper.join();
+
+    U64 nodes = 0;
+    U64 null_moves = 0;
+    U64 null_cutoffs = 0;
+    U64 tt_probes = 0;
+    U64 tt_hits = 0;
+    for (auto &state : states) {
+        nodes += state.nodes;
+        null_moves += state.null_moves;
+        null_cutoffs += state.null_cutoffs;
+        tt_probes += state.tt_probes;
+        tt_hits += state.tt_hits;
+    }
+
+    if (!limits.silent)
+        print("Nodes: " + std::to_string(nodes) + ", threads: " + std::to_string(num_threads) + ", TT hit rate: " + std::to_string(tt_probes ? 100.0 * tt_hits / tt_probes : 0) + "%" +
+            ", null move cutoffs: " + std::to_string(null_cutoffs) + "/" + std::to_string(null_moves));
+
+    if (stats) {
+        stats->nodes = nodes;
+        stats->depth = states[0].completed_depth;
+        stats->researches = states[0].researches;
+        stats->null_moves = null_moves;
+        stats->null_cutoffs = null_cutoffs;
+        stats->tt_probes = tt_probes;
+        stats->tt_hits = tt_hits;
+    }
+
+    return action;
+}
+
+// Returns the action found from board by the search mode limits asks for
+// search_stopped must be cleared before starting, so a stop can't be missed by a search started on another thread
+int smp_search(const ChessBoard &board, bool max_player_color, const std::vector<U64> &key_history, const SearchLimits &limits, SearchStats *stats) {
+    if (limits.mode == YBWC_MODE)
+        return ybwc_search(board, max_player_color, key_history, limits, stats);
+
+    return lazy_smp_search(board, max_player_color, key_history, limits, stats);
+}
+
+// Returns an action, searching with options (threads, mode, ...) for as long as the time manager plans
+int time_limited_iterative_deepening_depth_limited_minimax_alpha_beta_pruning_quiescence_search_history_table(std::string initial_fen, bool max_player_color, const std::vector<U64> &key_history, double time_remaining_ns, const SearchLimits &options, double increment_ns, double overhead_ns) {
+    ChessBoard board(initial_fen);
+    TimeManager time_manager;
+    SearchLimits limits = options;
+
+    // Determine allocated time for this move
+    time_manager.init(time_remaining_ns, increment_ns, overhead_ns, board, GET_TIME_NS());
+    limits.end_time = time_manager.hard_deadline();
+    limits.time_manager = &time_manager;
+
+    search_stopped = false;
+    return smp_search(board, max_player_color, key_history, limits);
 }
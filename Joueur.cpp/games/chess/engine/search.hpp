@@ -4,20 +4,58 @@
 #include "constants.hpp"
 #include "util.hpp"
 #include "state.hpp"
+#include "timeman.hpp"
+#include "transposition.hpp"
+#include <atomic>
+#include <string>
+#include <vector>
 
-int terminal_test(State state, std::vector<int> history);
+// What bounds a search
+struct SearchLimits {
+    double end_time = 0;              // GET_TIME_NS() deadline, 0 for none
+    int depth = 0;                    // Deepest depth to complete, 0 for no limit
+    int threads = 1;
+    int mode = LAZY_SMP_MODE;         // SearchModes
+    TimeManager *time_manager = NULL; // Decides when to stop iterating, NULL to go on until end_time
+    int aspiration_width = ASPIRATION_WIDTH; // 0 searches every depth with a full window
+    bool silent = false;              // Don't print progress
+};
 
-int depth_limited_minimax(State initial_state, std::vector<int> history);
-int iterative_deepening_depth_limited_minimax(std::string initial_fen, int max_depth_limit, bool max_player_color, std::vector<int> history);
-int max_value(State state, std::vector<int> history);
-int min_value(State state, std::vector<int> history);
+// What a search did
+struct SearchStats {
+    U64 nodes = 0;      // Over all threads
+    int depth = 0;      // Deepest depth the main thread completed
+    U64 steals = 0;     // YBWC tasks taken from another thread
+    double idle_ns = 0; // YBWC time spent looking for work, summed over threads
+    U64 researches = 0; // Main thread root searches repeated outside their aspiration window
+    U64 null_moves = 0;   // Null move searches tried, over all threads
+    U64 null_cutoffs = 0; // Of those, the ones that pruned their node
+    U64 tt_probes = 0;    // Transposition table lookups, over all threads
+    U64 tt_hits = 0;      // Of those, the ones that found their position
+};
 
-int time_limited_iterative_deepening_depth_limited_minimax_with_alpha_beta_pruning(std::string initial_fen, bool max_player_color, std::vector<int> history, double time_remaining_ns);
-int tliddlmmwabp_max_value(State state, int alpha, int beta, std::vector<int> history);
-int tliddlmmwabp_min_value(State state, int alpha, int beta, std::vector<int> history);
+// Set to stop every thread of the current search
+extern std::atomic<bool> search_stopped;
 
-int time_limited_iterative_deepening_depth_limited_minimax_alpha_beta_pruning_quiescence_search_history_table(std::string initial_fen, bool max_player_color, std::vector<int> move_history, double time_remaining_ns); 
-int tliddlmabpqsht_max_value(State state, int alpha, int beta, std::vector<int> move_history, std::unordered_map<int, int> &history_table);
-int tliddlmabpqsht_min_value(State state, int alpha, int beta, std::vector<int> move_history, std::unordered_map<int, int> &history_table);
+// While set the search ignores its limits and runs until stopped, without reading end_time or
+// time_manager. Clearing it (a ponder hit) makes the limits apply again, so they must be final beforehand
+extern std::atomic<bool> search_pondering;
+
+bool check_limits(const SearchLimits &limits);
+int terminal_test(State &state);
+
+bool tt_cutoff(State &state, int depth, int alpha, int beta, int &value, int &hash_move);
+void tt_store(const State &state, int depth, int alpha, int beta, int value, int best_action);
+bool null_move_cutoff(State &state, int depth, int alpha, int beta, bool in_check, int &value);
+int search_action(State &state, int action, int depth, int alpha, int beta);
+int quiescence_search(State &state, int alpha, int beta);
+int principal_variation_search(State &state, int depth, int alpha, int beta);
+
+int search_root(State &state, int depth, int alpha, int beta, int &best_action, const SearchLimits &limits);
+int iterative_deepening(State &state, int start_depth, const SearchLimits &limits, bool is_main);
+int lazy_smp_search(const ChessBoard &board, bool max_player_color, const std::vector<U64> &key_history, const SearchLimits &limits, SearchStats *stats=NULL);
+int smp_search(const ChessBoard &board, bool max_player_color, const std::vector<U64> &key_history, const SearchLimits &limits, SearchStats *stats=NULL);
+
+int time_limited_iterative_deepening_depth_limited_minimax_alpha_beta_pruning_quiescence_search_history_table(std::string initial_fen, bool max_player_color, const std::vector<U64> &key_history, double time_remaining_ns, const SearchLimits &options, double increment_ns=0, double overhead_ns=0);
 
 #endif // SEARCH_HPP
\ No newline at end of file
@@ -1,38 +1,104 @@
 #include "state.hpp"
 
-State::State(ChessBoard board, int depth, int qs_depth, bool max_player_color, bool is_quiescent) {
+State::State(ChessBoard board, bool max_player_color, const std::vector<U64> &key_history) {
     this->board = board;
-    this->depth = depth;
-    this->qs_depth = qs_depth;
     this->max_player_color = max_player_color;
-    this->is_quiescent = is_quiescent;
-        
-    if (this->depth || this->qs_depth) {
-       this->board.actions(this->actions);
+    this->ply = 0;
+    this->frames.resize(MAX_PLY + 1);
+    this->key_history = key_history;
+    this->reset_stats();
+    this->null_move_min_ply = 0;
+    this->null_move_color = WHITE;
+    this->limits = NULL;
+    this->completed_depth = 0;
+    this->worker = NULL;
+    this->split = NULL;
+
+    for (auto &table : this->history)
+        for (auto &from : table)
+            from.fill(0);
+
+    for (auto &table : this->countermoves)
+        for (auto &piece : table)
+            piece.fill(0);
+
+    // Too big for the stack, so the tables live on the heap (zeroed)
+    this->continuation_history.resize(NUM_COLORS * CONTINUATION_PLIES);
+
+    for (auto &frame : this->frames) {
+        frame.current_move = 0;
+        frame.static_eval = 0;
+        std::fill(frame.killers, frame.killers + NUM_KILLERS, 0);
     }
-    else {
-        // Don't calculate actions if the depth limit is reached    
-        this->actions = {0};
+
+    this->frames[0].key = this->board.key;
+}
+
+// Zeroes the search statistics, which copies of a state mustn't count twice
+void State::reset_stats(void) {
+    this->nodes = 0;
+    this->researches = 0;
+    this->null_moves = 0;
+    this->null_cutoffs = 0;
+    this->tt_probes = 0;
+    this->tt_hits = 0;
+}
+
+// Moves this state to state's current position, keeping this state's own search data
+void State::copy_position(const State &state) {
+    this->board = state.board;
+    this->max_player_color = state.max_player_color;
+    this->ply = state.ply;
+    this->key_history = state.key_history;
+    this->null_move_min_ply = state.null_move_min_ply;
+    this->null_move_color = state.null_move_color;
+
+    // The moves leading here too, move ordering follows on from them
+    for (int ply = 0; ply <= this->ply; ply++) {
+        this->frames[ply].key = state.frames[ply].key;
+        this->frames[ply].current_move = state.frames[ply].current_move;
     }
 }
 
-// Returns the resulting state after applying move to this->board
-State State::result(int move) {
-    // This state is considered quiescent (in this case) if this move is not an attack move and not a pawn promotion move
-    // NOTE: This quiescent check can be improved upon
-    bool is_quiescent = !(move & ATTACK_MOVE_MASK) && !(move & PROMO_MOVE_MASK);
+// Fills the current frame's actions with the moves of the GenerationModes mode
+void State::generate_actions(int mode) {
+    MoveList &actions = this->frame().actions;
+    actions.clear();
+    this->board.actions(actions, mode);
+}
 
-    int new_depth = this->depth;
-    int new_qs_depth = this->qs_depth;
+// Makes move on this->board and steps up to the next ply
+void State::make_move(int move) {
+    SearchFrame &frame = this->frame();
+    frame.current_move = move;
+    this->board.make_move(move, frame.undo);
 
-    if (this->depth <= 0) {
-        // Only quiescent depth remains
-        new_qs_depth--;
-    } else {
-        new_depth--;
-    }
+    this->ply++;
+    this->frame().key = this->board.key;
+}
+
+// Takes back the move made from the previous ply
+void State::unmake_move(void) {
+    this->ply--;
 
-    return State(this->board.apply_move(move), new_depth, new_qs_depth, this->max_player_color, is_quiescent);
+    SearchFrame &frame = this->frame();
+    this->board.unmake_move(frame.current_move, frame.undo);
+}
+
+// Passes the turn (a null move) and steps up to the next ply
+void State::make_null_move(void) {
+    SearchFrame &frame = this->frame();
+    frame.current_move = 0;
+    this->board.make_null_move(frame.undo);
+
+    this->ply++;
+    this->frame().key = this->board.key;
+}
+
+// Takes back the null move made from the previous ply
+void State::unmake_null_move(void) {
+    this->ply--;
+    this->board.unmake_null_move(this->frame().undo);
 }
 
 // Returns the utility value (either actual or material advantage) of this state based on
@@ -65,21 +131,29 @@ int State::utility(int terminal_result) {
     }
 }
 
-bool State::check_3_fold_rep(std::vector<int> history) {
-    int last_index = history.size() - 1;    
-
-    return (last_index >= 8) &&
-           (history[last_index    ] & history[last_index - 4] & ATTACK_MOVE_MASK & TO_FILE_A_MOVE_MASK & TO_RANK_MOVE_MASK) == 
-           (history[last_index    ] &                           ATTACK_MOVE_MASK & TO_FILE_A_MOVE_MASK & TO_RANK_MOVE_MASK) &&
-
-           (history[last_index - 1] & history[last_index - 5] & ATTACK_MOVE_MASK & TO_FILE_A_MOVE_MASK & TO_RANK_MOVE_MASK) == 
-           (history[last_index - 1] &                           ATTACK_MOVE_MASK & TO_FILE_A_MOVE_MASK & TO_RANK_MOVE_MASK) &&
-
-           (history[last_index - 2] & history[last_index - 6] & ATTACK_MOVE_MASK & TO_FILE_A_MOVE_MASK & TO_RANK_MOVE_MASK) == 
-           (history[last_index - 2] &                           ATTACK_MOVE_MASK & TO_FILE_A_MOVE_MASK & TO_RANK_MOVE_MASK) &&
+// Returns true if this position has occurred twice before, looking back through the
+// search stack and then the game's key_history
+// Only positions since the last capture, pawn move or null move with the same side to move can match
+bool State::check_3_fold_rep(void) {
+    int repetitions = 0;
+    int reach = std::min((int)this->board.half_moves, this->ply + (int)this->key_history.size());
+    U64 key;
+
+    for (int distance = 2; distance <= reach; distance += 2) {
+        if (distance <= this->ply && (!this->frames[this->ply - distance].current_move || !this->frames[this->ply - distance + 1].current_move))
+            // A side passed in between, so what came before was never really repeated
+            break;
+
+        if (distance <= this->ply)
+            key = this->frames[this->ply - distance].key;
+        else
+            key = this->key_history[this->key_history.size() - (distance - this->ply)];
+
+        if (key == this->board.key && ++repetitions == 2)
+            return true;
+    }
 
-           (history[last_index - 3] & history[last_index - 7] & ATTACK_MOVE_MASK & TO_FILE_A_MOVE_MASK & TO_RANK_MOVE_MASK) == 
-           (history[last_index - 3] &                           ATTACK_MOVE_MASK & TO_FILE_A_MOVE_MASK & TO_RANK_MOVE_MASK);
+    return false;
 }
 
 // Returns true if there is insufficient material to continue the game, false otherwise.
@@ -97,8 +171,7 @@ bool State::insufficient_material(void) {
     bool king_and_bishop_versus_king_and_bishop_with_bishops_on_same_color = true;
 
     // Get which pieces are still in play
-    std::vector<int> piece_counts;
-    piece_counts.reserve(NUM_BITBOARDS);
+    std::array<int, NUM_BITBOARDS> piece_counts;
     int piece_count;
     int bb_index = 0;
     while (bb_index < NUM_BITBOARDS && (
@@ -126,7 +199,7 @@ bool State::insufficient_material(void) {
             king_and_bishop_versus_king_and_bishop_with_bishops_on_same_color = king_and_bishop_versus_king;
         }
         
-        piece_counts.push_back(piece_count);
+        piece_counts[bb_index] = piece_count;
         bb_index++;
     }
             
@@ -141,7 +214,7 @@ bool State::insufficient_material(void) {
     
     king_and_bishop_versus_king_and_bishop_with_bishops_on_same_color = (piece_counts[WB] && piece_counts[BB]) &&
         count_set_bits(this->board.bitboards[WB]) == 1 && count_set_bits(this->board.bitboards[BB]) == 1 &&
-        DIAG_RAYS[this->board.bitboards[WB]] & this->board.bitboards[BB];
+        DIAG_RAYS[get_square(this->board.bitboards[WB])] & this->board.bitboards[BB];
     
     return  king_versus_king ||
             king_and_bishop_versus_king ||
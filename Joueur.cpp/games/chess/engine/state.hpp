@@ -2,21 +2,102 @@
 #define STATE_HPP
 
 #include "chessboard.hpp"
+#include "movelist.hpp"
+#include <algorithm>
+#include <array>
 #include <vector>
 
+struct SearchLimits;
+struct SplitPoint;
+class YBWCWorker;
+
+// A value per from & to square pair
+typedef std::array<std::array<int, BITBOARD_SIZE>, BITBOARD_SIZE> ButterflyTable;
+
+// A value per piece type & to square
+typedef std::array<std::array<int, BITBOARD_SIZE>, NUM_PIECE_TYPES> PieceToTable;
+
+// A PieceToTable per piece type & to square of an earlier move
+typedef std::array<std::array<PieceToTable, BITBOARD_SIZE>, NUM_PIECE_TYPES> ContinuationTable;
+
+// Per-ply search data
+struct SearchFrame {
+    MoveList actions;
+    int current_move;          // Move being searched from this ply, 0 for a null move
+    int static_eval;
+    int killers[NUM_KILLERS];
+    U64 key;                   // Zobrist key of the position at this ply
+    UndoInfo undo;             // Undoes current_move
+};
+
+// The position being searched along with the stack of frames leading to it from the root
+// The frames are allocated once per search and moves are made and unmade in place, so
+// searching a node never copies the board or allocates
 class State {
 public:
     ChessBoard board;
-    int depth;
-    int qs_depth;
     bool max_player_color;
-    bool is_quiescent;
-    std::vector<int> actions;
+    int ply;
+    std::vector<SearchFrame> frames;
+    std::vector<U64> key_history; // Keys of every game position before the root
+    std::array<ButterflyTable, NUM_COLORS> history; // How well each side's moves have done at causing cutoffs
+    std::array<PieceToTable, NUM_COLORS> countermoves; // Each side's last quiet cutoff move in reply to a move
+    std::vector<ContinuationTable> continuation_history; // Quiet move history following on from the moves 1 & 2 plies earlier
+    U64 nodes;
+    U64 researches;              // Root searches repeated after falling outside their aspiration window
+    U64 null_moves;              // Null move searches tried
+    U64 null_cutoffs;            // Null move searches that pruned their node
+    U64 tt_probes;               // Transposition table lookups
+    U64 tt_hits;                 // Of those, the ones that found their position
+    int null_move_min_ply;       // Verifying a null move cutoff: null_move_color can't pass again before this ply
+    bool null_move_color;
+    const SearchLimits *limits;  // Polled every TIME_CHECK_NODES nodes, NULL for none
+    int completed_depth; // Deepest iteration finished
+    YBWCWorker *worker;  // Thread searching this state in YBWC mode, NULL otherwise
+    SplitPoint *split;   // Split point this state's position was handed out from, NULL if none
+
+    State(ChessBoard board, bool max_player_color, const std::vector<U64> &key_history);
+
+    SearchFrame &frame(void) {
+        return this->frames[this->ply];
+    }
+
+    // Returns the continuation history of moves from the current position following on from
+    // the move plies_back plies earlier, NULL if that's before the root
+    PieceToTable *continuation(int plies_back) {
+        if (this->ply < plies_back || !this->frames[this->ply - plies_back].current_move)
+            return NULL;
+
+        // Made by the opponent when plies_back is odd
+        int move = this->frames[this->ply - plies_back].current_move;
+        bool color = this->board.color ^ (plies_back & 1);
+        ContinuationTable &table = this->continuation_history[this->board.color * CONTINUATION_PLIES + plies_back - 1];
+        return &table[get_piece_index(move)][get_to_square(move, color)];
+    }
+
+    // Returns the countermove slot for the opponent's last move, NULL at the root
+    int *countermove(void) {
+        if (!this->ply || !this->frames[this->ply - 1].current_move)
+            return NULL;
+
+        int move = this->frames[this->ply - 1].current_move;
+        return &this->countermoves[this->board.color][get_piece_index(move)][get_to_square(move, !this->board.color)];
+    }
+
+    void reset_stats(void);
+    void copy_position(const State &state);
+    void generate_actions(int mode=ALL_MOVES);
+    // Returns true if the side to move is allowed a null move by any null move verification in progress
+    bool null_move_allowed(void) const {
+        return this->ply >= this->null_move_min_ply || this->board.color != this->null_move_color;
+    }
 
-    State(ChessBoard board, int depth, int qs_depth, bool max_player_color, bool is_quiescent=true);
-    State result(int move);
+    void make_move(int move);
+    void unmake_move(void);
+    void make_null_move(void);
+    void unmake_null_move(void);
     int utility(int terminal_result);
-    bool check_3_fold_rep(std::vector<int> history);
+    bool check_3_fold_rep(void);
     bool insufficient_material(void);
 };
 
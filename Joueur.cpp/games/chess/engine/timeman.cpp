@@ -0,0 +1,118 @@
+#include "timeman.hpp"
+#include "util.hpp"
+#include <algorithm>
+
+ClockMonitor::ClockMonitor() : num_samples(0), last_time_remaining(0), last_think_ns(0), increment_ns(0) {
+    this->samples.fill(0);
+}
+
+// Records our clock at the start of our move, measuring what the last move really cost
+void ClockMonitor::start_move(double time_remaining_ns) {
+    if (!this->last_time_remaining)
+        return;
+
+    double unexplained = (this->last_time_remaining - time_remaining_ns) - this->last_think_ns;
+
+    if (unexplained >= 0) {
+        this->samples[this->num_samples % TM_OVERHEAD_SAMPLES] = unexplained;
+        this->num_samples++;
+        this->increment_ns = 0;
+    }
+    else {
+        this->increment_ns = -unexplained;
+    }
+}
+
+// Records our clock at the start of the move we just made and how long we took
+void ClockMonitor::end_move(double time_remaining_ns, double think_ns) {
+    this->last_time_remaining = time_remaining_ns;
+    this->last_think_ns = think_ns;
+}
+
+// Returns a high percentile of the recent overheads, so one unlucky move can't flag us
+double ClockMonitor::overhead_ns(void) const {
+    if (!this->num_samples)
+        return TM_DEFAULT_OVERHEAD_NS;
+
+    int count = std::min(this->num_samples, TM_OVERHEAD_SAMPLES);
+    std::array<double, TM_OVERHEAD_SAMPLES> sorted = this->samples;
+    std::sort(sorted.begin(), sorted.begin() + count);
+
+    return sorted[std::min(count - 1, (int)(count * TM_OVERHEAD_PERCENTILE))];
+}
+
+TimeManager::TimeManager() : start_time(0), soft_ns(0), hard_ns(0), last_iteration_end(0), last_iteration_ns(0),
+    prev_best_action(0), prev_best_value(0), stable_iterations(0), instability(0) {}
+
+// Plans the move from board with time_remaining_ns on the clock, starting at start_time
+// Every move costs overhead_ns on top of the time searched
+void TimeManager::init(double time_remaining_ns, double increment_ns, double overhead_ns, const ChessBoard &board, double start_time) {
+    // The game phase, 1 with every piece on the board down to 0 with only pawns
+    int material = 0;
+    for (int bitboard_index = 0; bitboard_index < NUM_BITBOARDS / 2; bitboard_index++) {
+        if (WHITE_BITBOARD_INDICES[bitboard_index] == WP)
+            continue;
+
+        material += PIECE_WEIGHTS[bitboard_index] * (count_set_bits(board.bitboards[WHITE_BITBOARD_INDICES[bitboard_index]]) +
+            count_set_bits(board.bitboards[BLACK_BITBOARD_INDICES[bitboard_index]]));
+    }
+    double phase = std::min(1.0, (double)material / STARTING_NON_PAWN_MATERIAL);
+
+    // Fewer moves are left as pieces come off the board and as the game goes on
+    double moves_to_go = TM_MIN_MOVES_TO_GO + (TM_MAX_MOVES_TO_GO - TM_MIN_MOVES_TO_GO) * phase;
+    moves_to_go = std::min(moves_to_go, std::max(TM_MIN_MOVES_TO_GO, TM_EXPECTED_GAME_LENGTH - board.whole_moves));
+
+    // Keep back the overhead of every move to go, and of this one for the hard maximum
+    double searchable_ns = std::max(0.0, time_remaining_ns - overhead_ns * moves_to_go);
+
+    this->hard_ns = time_remaining_ns * TM_MAX_CLOCK_SHARE - overhead_ns;
+    this->soft_ns = searchable_ns / moves_to_go + increment_ns * TM_INCREMENT_USE;
+    this->hard_ns = std::max(TM_MIN_THINK_NS, std::min(this->soft_ns * TM_HARD_RATIO, this->hard_ns));
+    this->soft_ns = std::min(this->soft_ns, this->hard_ns);
+
+    this->start_time = start_time;
+    this->last_iteration_end = GET_TIME_NS();
+    this->last_iteration_ns = 0;
+    this->prev_best_action = 0;
+    this->prev_best_value = 0;
+    this->stable_iterations = 0;
+    this->instability = 0;
+}
+
+// Returns true if the search should stop after the iteration that just finished with best_action scored best_value
+bool TimeManager::stop_iterating(int best_action, int best_value) {
+    double now = GET_TIME_NS();
+    double elapsed = now - this->start_time;
+    double iteration_ns = now - this->last_iteration_end;
+    double scale = 1;
+
+    if (this->prev_best_action) {
+        if (best_action == this->prev_best_action) {
+            this->stable_iterations++;
+        }
+        else {
+            this->stable_iterations = 0;
+            this->instability++;
+        }
+
+        // A falling score means trouble, take time to look for a way out
+        if (best_value < this->prev_best_value)
+            scale *= std::min(TM_MAX_SCORE_DROP_SCALE, 1 + TM_SCORE_DROP_WEIGHT * (this->prev_best_value - best_value));
+    }
+
+    // A settled best move needs less time, one that keeps changing needs more
+    scale *= std::max(TM_MIN_STABILITY_SCALE, 1 - TM_STABILITY_STEP * this->stable_iterations);
+    scale *= 1 + TM_INSTABILITY_WEIGHT * this->instability;
+    this->instability *= TM_INSTABILITY_DECAY;
+
+    // Iterations grow by about as much as the last one did
+    double growth = this->last_iteration_ns ? iteration_ns / this->last_iteration_ns : TM_MAX_GROWTH;
+    growth = std::min(TM_MAX_GROWTH, std::max(TM_MIN_GROWTH, growth));
+
+    this->prev_best_action = best_action;
+    this->prev_best_value = best_value;
+    this->last_iteration_end = now;
+    this->last_iteration_ns = iteration_ns;
+
+    return elapsed >= std::min(this->soft_ns * scale, this->hard_ns) || elapsed + iteration_ns * growth > this->hard_ns;
+}
@@ -0,0 +1,60 @@
+#ifndef TIMEMAN_HPP
+#define TIMEMAN_HPP
+
+#include "chessboard.hpp"
+#include "constants.hpp"
+#include <array>
+
+// Learns what the server charges our clock for besides our own think time (sending,
+// serializing & processing the move) from how the clock changes between our moves
+//
+// The clock only runs on our turn, so between two of our moves it should drop by
+// exactly our think time. Whatever more it drops by is overhead. If it drops by less
+// there must be an increment, and what's measured is the increment net of overhead.
+class ClockMonitor {
+private:
+    std::array<double, TM_OVERHEAD_SAMPLES> samples; // Recent overheads, a ring buffer
+    int num_samples;
+    double last_time_remaining; // Our clock when our last move started, 0 before our first
+    double last_think_ns;       // How long our last move took us
+
+public:
+    double increment_ns;        // Net of overhead, 0 if there is none
+
+    ClockMonitor();
+    void start_move(double time_remaining_ns);
+    void end_move(double time_remaining_ns, double think_ns);
+    double overhead_ns(void) const;
+};
+
+// Plans how long to search one move
+//
+// The soft target is this move's share of the clock, from the time left (less the
+// overhead every move to go will cost), the move number and how much material is
+// left. The hard maximum is the search's deadline.
+// Iterative deepening asks after every iteration whether to go on: it stops once the
+// soft target (shrunk while the best move holds, grown when it changes or the score
+// drops) has passed, or when the next iteration couldn't finish before the hard maximum.
+class TimeManager {
+private:
+    double start_time;
+    double soft_ns;
+    double hard_ns;
+    double last_iteration_end;
+    double last_iteration_ns;
+    int prev_best_action;
+    int prev_best_value;
+    int stable_iterations; // Iterations in a row the best move hasn't changed
+    double instability;    // Decaying count of best move changes
+
+public:
+    TimeManager();
+    void init(double time_remaining_ns, double increment_ns, double overhead_ns, const ChessBoard &board, double start_time);
+    bool stop_iterating(int best_action, int best_value);
+
+    double hard_deadline(void) const {
+        return this->start_time + this->hard_ns;
+    }
+};
+
+#endif // TIMEMAN_HPP
@@ -0,0 +1,129 @@
+#include "transposition.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+// Data word layout
+constexpr int TT_MOVE_BITS = 28;
+constexpr int TT_SCORE_SHIFT = TT_MOVE_BITS;
+constexpr int TT_DEPTH_SHIFT = TT_SCORE_SHIFT + 16;
+constexpr int TT_BOUND_SHIFT = TT_DEPTH_SHIFT + 8;
+constexpr int TT_AGE_SHIFT = TT_BOUND_SHIFT + 2;
+constexpr int TT_AGE_MASK = 0x3F;
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+static U64 pack(int move, int score, int depth, int bound, int age) {
+    return (U64)(move & ((1 << TT_MOVE_BITS) - 1)) |
+           ((U64)(uint16_t)(int16_t)score << TT_SCORE_SHIFT) |
+           ((U64)(uint8_t)depth << TT_DEPTH_SHIFT) |
+           ((U64)bound << TT_BOUND_SHIFT) |
+           ((U64)age << TT_AGE_SHIFT);
+}
+
+static int unpack_depth(U64 data) {
+    return (int)((data >> TT_DEPTH_SHIFT) & 0xFF);
+}
+
+static int unpack_age(U64 data) {
+    return (int)(data >> TT_AGE_SHIFT) & TT_AGE_MASK;
+}
+
+TranspositionTable TT;
+
+TranspositionTable::TranspositionTable(int megabytes) : buckets(NULL), index_mask(0), age(0) {
+    this->resize(megabytes);
+}
+
+// Reallocates the table with the largest power of two number of buckets that fits in megabytes
+// Not safe to call while a search is running
+void TranspositionTable::resize(int megabytes) {
+    static_assert(sizeof(Bucket) == CACHE_LINE_SIZE, "A bucket should fill a cache line");
+
+    size_t num_buckets = 1;
+    while (num_buckets * 2 * sizeof(Bucket) <= ((size_t)std::max(megabytes, 1) << 20))
+        num_buckets *= 2;
+
+    this->storage.reset(new char[num_buckets * sizeof(Bucket) + CACHE_LINE_SIZE]);
+    this->buckets = reinterpret_cast<Bucket *>(((uintptr_t)this->storage.get() + CACHE_LINE_SIZE - 1) & ~(uintptr_t)(CACHE_LINE_SIZE - 1));
+    this->index_mask = num_buckets - 1;
+
+    for (size_t b = 0; b < num_buckets; b++)
+        new (&this->buckets[b]) Bucket();
+
+    this->clear();
+}
+
+// Empties every entry
+void TranspositionTable::clear(void) {
+    for (U64 b = 0; b <= this->index_mask; b++) {
+        for (int e = 0; e < TT_BUCKET_SIZE; e++) {
+            this->buckets[b].entries[e].check.store(0, std::memory_order_relaxed);
+            this->buckets[b].entries[e].data.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    this->age = 0;
+}
+
+// Call before every search: ages existing entries
+void TranspositionTable::new_search(void) {
+    this->age = (this->age + 1) & TT_AGE_MASK;
+}
+
+// Fills entry and returns true if key is stored
+bool TranspositionTable::probe(U64 key, TTEntry &entry) {
+    const Bucket &bucket = this->buckets[key & this->index_mask];
+
+    for (int e = 0; e < TT_BUCKET_SIZE; e++) {
+        U64 data = bucket.entries[e].data.load(std::memory_order_relaxed);
+        U64 check = bucket.entries[e].check.load(std::memory_order_relaxed);
+
+        if ((check ^ data) == key && data) {
+            entry.move = (int)(data & ((1 << TT_MOVE_BITS) - 1));
+            entry.score = (int16_t)(uint16_t)(data >> TT_SCORE_SHIFT);
+            entry.depth = unpack_depth(data);
+            entry.bound = (int)(data >> TT_BOUND_SHIFT) & 0x3;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Stores a search result for key
+// An existing entry for key is overwritten unless it is from this search and deeper (keeping
+// its move if the new result has none). Otherwise the entry replaced is the one whose depth,
+// less a penalty for each search it has aged through, is lowest
+void TranspositionTable::store(U64 key, int depth, int score, int bound, int move) {
+    Bucket &bucket = this->buckets[key & this->index_mask];
+    Entry *replace = NULL;
+    int replace_value = INT_MAX;
+
+    for (int e = 0; e < TT_BUCKET_SIZE; e++) {
+        Entry &entry = bucket.entries[e];
+        U64 data = entry.data.load(std::memory_order_relaxed);
+        U64 check = entry.check.load(std::memory_order_relaxed);
+
+        if ((check ^ data) == key && data) {
+            if (!move)
+                move = (int)(data & ((1 << TT_MOVE_BITS) - 1));
+
+            if (unpack_age(data) == this->age && unpack_depth(data) > depth && bound != TT_EXACT)
+                return;
+
+            replace = &entry;
+            break;
+        }
+
+        int value = unpack_depth(data) - 4 * ((this->age - unpack_age(data)) & TT_AGE_MASK);
+        if (value < replace_value) {
+            replace_value = value;
+            replace = &entry;
+        }
+    }
+
+    U64 data = pack(move, score, depth, bound, this->age);
+    replace->data.store(data, std::memory_order_relaxed);
+    replace->check.store(key ^ data, std::memory_order_relaxed);
+}
@@ -0,0 +1,60 @@
+#ifndef TRANSPOSITION_HPP
+#define TRANSPOSITION_HPP
+
+#include "constants.hpp"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// What a stored score says about the true score
+enum TTBound {
+    TT_NONE,
+    TT_EXACT, // The score is exact
+    TT_LOWER, // The true score is at least the score (the search failed high)
+    TT_UPPER, // The true score is at most the score (the search failed low)
+};
+
+// An unpacked transposition table entry
+struct TTEntry {
+    int move;  // Best move found, 0 if none
+    int score;
+    int depth; // Remaining depth the score was searched to
+    int bound; // TTBound
+};
+
+// Shared hash table of search results keyed by Zobrist key
+//
+// Entries are grouped into cache line sized buckets that share an index. Each
+// entry is a data word and a check word holding key ^ data, both relaxed atomics,
+// so threads can read & write without locks: a read that races a write sees a
+// check word that doesn't match its data word and is treated as a miss.
+// Probes & hits are counted by each search thread (State), so threads don't
+// contend over shared counters.
+class TranspositionTable {
+private:
+    struct Entry {
+        std::atomic<U64> check; // key ^ data
+        std::atomic<U64> data;  // Packed move, score, depth, bound & age
+    };
+
+    struct Bucket {
+        Entry entries[TT_BUCKET_SIZE];
+    };
+
+    std::unique_ptr<char[]> storage; // Backs buckets, over-allocated to align them to a cache line
+    Bucket *buckets;
+    U64 index_mask;
+    int age; // Bumped every search so entries from earlier searches are replaced first
+
+public:
+    TranspositionTable(int megabytes = DEFAULT_TT_MEGABYTES);
+    void resize(int megabytes);
+    void clear(void);
+    void new_search(void);
+    bool probe(U64 key, TTEntry &entry);
+    void store(U64 key, int depth, int score, int bound, int move);
+};
+
+extern TranspositionTable TT;
+
+#endif // TRANSPOSITION_HPP
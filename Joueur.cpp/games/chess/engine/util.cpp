@@ -146,541 +146,146 @@ bool str_contains(std::string str1, char str2) {
     return (str1.find(str2) != std::string::npos);
 }
 
-// Returns true if item is in map, false otherwise
-bool map_contains(std::unordered_map<U64, U64> map, U64 item) {
-    return (map.find(item) != map.end());
-}
+// Returns the square named by a file & rank string (such as "e3"),
+// NO_EN_PASSANT_SQUARE for the FEN placeholder "-"
+int file_rank_to_square(std::string file_rank) {
+    if (file_rank.size() != 2)
+        return NO_EN_PASSANT_SQUARE;
 
-// Returns true if item is in set, false otherwise
-bool set_contains(std::set<U64> set, U64 item) {
-    return (set.find(item) != set.end());
-}
+    int col = file_rank[0] - FILE_A_CHAR;
+    int row = RANK_8_CHAR - file_rank[1];
 
-// Returns true if the move is contained in the history table
-bool ht_contains(std::unordered_map<int, int> ht, int move) {
-    return (ht.find(move) != ht.end());
+    return row * 8 + col;
 }
 
-std::vector<U64> split_bitboard(U64 bitboard) {
-    std::vector<U64> set_bit_indices;
-    int bit_index = 0;
-    
-    while (bitboard) {
-        if (bitboard & 1)
-            set_bit_indices.push_back(bit_index);
-        
-        bit_index++;
-        bitboard >>= 1;
-    }
-    
-    for (int i = 0; i < set_bit_indices.size(); i++)
-        set_bit_indices[i] = shift_left(1, set_bit_indices[i]);
+// Compile-time table generation
+// Squares are indexed by bit position: square 0 is a8 and square 63 is h1, so a
+// square's row counts down from rank 8 and its column counts across from file A
 
-    return set_bit_indices;
+// Returns true if the row & column lie on the board
+constexpr bool on_board(int row, int col) {
+    return row >= 0 && row < 8 && col >= 0 && col < 8;
 }
 
-// Generate the piece for all ranks & files
-std::unordered_map<std::string, U64> get_file_rank_to_piece_str(void) {
-    std::string file_rank;
-    U64 mask;
-    std::unordered_map<std::string, U64> file_rank_to_piece;
-    
-    for (int bit_index = 0; bit_index < BITBOARD_SIZE; bit_index++) {
-        mask = shift_left(1, bit_index);
-
-        // Determine file
-        if (mask & FILE_A)
-            file_rank += FILE_A_CHAR;
-        else if (mask & FILE_B)
-            file_rank += FILE_B_CHAR;
-        else if (mask & FILE_C)
-            file_rank += FILE_C_CHAR;
-        else if (mask & FILE_D)
-            file_rank += FILE_D_CHAR;
-        else if (mask & FILE_E)
-            file_rank += FILE_E_CHAR;
-        else if (mask & FILE_F)
-            file_rank += FILE_F_CHAR;
-        else if (mask & FILE_G)
-            file_rank += FILE_G_CHAR;
-        else // if (mask & FILE_H)
-            file_rank += FILE_H_CHAR;
-        
-        // Determine rank
-        if (mask & RANK_1)
-            file_rank += RANK_1_CHAR;
-        else if (mask & RANK_2)
-            file_rank += RANK_2_CHAR;
-        else if (mask & RANK_3)
-            file_rank += RANK_3_CHAR;
-        else if (mask & RANK_4)
-            file_rank += RANK_4_CHAR;
-        else if (mask & RANK_5)
-            file_rank += RANK_5_CHAR;
-        else if (mask & RANK_6)
-            file_rank += RANK_6_CHAR;
-        else if (mask & RANK_7)
-            file_rank += RANK_7_CHAR;
-        else // if (mask & RANK_8)
-            file_rank += RANK_8_CHAR;
-
-        file_rank_to_piece[file_rank] = mask;
-    }
-
-    // Add en passant
-    file_rank_to_piece[NO_EN_PASSANT_STR] = 0;
-    
-    return file_rank_to_piece;
+// Returns the bitboard one (d_row, d_col) step away from square, 0 if that step leaves the board
+constexpr U64 step(int square, int d_row, int d_col) {
+    return on_board(square / 8 + d_row, square % 8 + d_col) ? (U64)1 << (square + d_row * 8 + d_col) : 0;
 }
 
-std::unordered_map<std::string, U64> FILE_RANK_TO_PIECE = get_file_rank_to_piece_str();
-
-// Generate the file & rank for all pieces
-std::unordered_map<U64, std::string> get_piece_to_file_rank(void) {
-    std::string file_rank;
-    U64 mask;
-    std::unordered_map<U64, std::string> piece_to_file_rank;
-    
-    for (int bit_index = 0; bit_index < BITBOARD_SIZE; bit_index++) {
-        file_rank = "";
-        mask = shift_left(1, bit_index);
-
-        // Determine file
-        if (mask & FILE_A)
-            file_rank += FILE_A_CHAR;
-        else if (mask & FILE_B)
-            file_rank += FILE_B_CHAR;
-        else if (mask & FILE_C)
-            file_rank += FILE_C_CHAR;
-        else if (mask & FILE_D)
-            file_rank += FILE_D_CHAR;
-        else if (mask & FILE_E)
-            file_rank += FILE_E_CHAR;
-        else if (mask & FILE_F)
-            file_rank += FILE_F_CHAR;
-        else if (mask & FILE_G)
-            file_rank += FILE_G_CHAR;
-        else // if (mask & FILE_H)
-            file_rank += FILE_H_CHAR;
-        
-        // Determine rank
-        if (mask & RANK_1)
-            file_rank += RANK_1_CHAR;
-        else if (mask & RANK_2)
-            file_rank += RANK_2_CHAR;
-        else if (mask & RANK_3)
-            file_rank += RANK_3_CHAR;
-        else if (mask & RANK_4)
-            file_rank += RANK_4_CHAR;
-        else if (mask & RANK_5)
-            file_rank += RANK_5_CHAR;
-        else if (mask & RANK_6)
-            file_rank += RANK_6_CHAR;
-        else if (mask & RANK_7)
-            file_rank += RANK_7_CHAR;
-        else // if (mask & RANK_8)
-            file_rank += RANK_8_CHAR;
-            
-        piece_to_file_rank[mask] = file_rank;
-    }
-
-    return piece_to_file_rank;
+// Returns every square in the (d_row, d_col) direction from square up to the edge of the board
+constexpr U64 ray(int square, int d_row, int d_col) {
+    return step(square, d_row, d_col) ? step(square, d_row, d_col) | ray(square + d_row * 8 + d_col, d_row, d_col) : 0;
 }
 
-std::unordered_map<U64, std::string> PIECE_TO_FILE_RANK = get_piece_to_file_rank();
-
-// Generate the piece move mask for all ranks & files
-std::unordered_map<U64, int> get_piece_to_file_rank_move_mask__from(void) {
-    int file_rank;
-    U64 mask;
-    std::unordered_map<U64, int> file_rank_to_piece;
-    
-    for (int bit_index = 0; bit_index < BITBOARD_SIZE; bit_index++) {
-        mask = shift_left(1, bit_index);
-        file_rank = 0;
-
-        // Determine file
-        if (mask & FILE_A)
-            file_rank |= FROM_FILE_A_MOVE_MASK;
-        else if (mask & FILE_B)
-            file_rank |= FROM_FILE_B_MOVE_MASK;
-        else if (mask & FILE_C)
-            file_rank |= FROM_FILE_C_MOVE_MASK;
-        else if (mask & FILE_D)
-            file_rank |= FROM_FILE_D_MOVE_MASK;
-        else if (mask & FILE_E)
-            file_rank |= FROM_FILE_E_MOVE_MASK;
-        else if (mask & FILE_F)
-            file_rank |= FROM_FILE_F_MOVE_MASK;
-        else if (mask & FILE_G)
-            file_rank |= FROM_FILE_G_MOVE_MASK;
-        else // if (mask & FILE_H)
-            file_rank |= FROM_FILE_H_MOVE_MASK;
-        
-        // Determine rank
-        if (mask & RANK_1)
-            file_rank |= FROM_RANK_1_MOVE_MASK;
-        else if (mask & RANK_2)
-            file_rank |= FROM_RANK_2_MOVE_MASK;
-        else if (mask & RANK_3)
-            file_rank |= FROM_RANK_3_MOVE_MASK;
-        else if (mask & RANK_4)
-            file_rank |= FROM_RANK_4_MOVE_MASK;
-        else if (mask & RANK_5)
-            file_rank |= FROM_RANK_5_MOVE_MASK;
-        else if (mask & RANK_6)
-            file_rank |= FROM_RANK_6_MOVE_MASK;
-        else if (mask & RANK_7)
-            file_rank |= FROM_RANK_7_MOVE_MASK;
-        else // if (mask & RANK_8)
-            file_rank |= FROM_RANK_8_MOVE_MASK;
-
-        file_rank_to_piece[mask] = file_rank;
-    }
-
-    return file_rank_to_piece;
+constexpr U64 diag_rays(int square) {
+    return ray(square, 1, 1) | ray(square, 1, -1) | ray(square, -1, 1) | ray(square, -1, -1);
 }
 
-std::unordered_map<U64, int> PIECE_TO_FILE_RANK_MOVE_MASK__FROM = get_piece_to_file_rank_move_mask__from();
-
-std::unordered_map<U64, int> get_piece_to_file_rank_move_mask__to(void) {
-    int file_rank;
-    U64 mask;
-    std::unordered_map<U64, int> file_rank_to_piece;
-    
-    for (int bit_index = 0; bit_index < BITBOARD_SIZE; bit_index++) {
-        mask = shift_left(1, bit_index);
-        file_rank = 0;
-
-        // Determine file
-        if (mask & FILE_A)
-            file_rank |= TO_FILE_A_MOVE_MASK;
-        else if (mask & FILE_B)
-            file_rank |= TO_FILE_B_MOVE_MASK;
-        else if (mask & FILE_C)
-            file_rank |= TO_FILE_C_MOVE_MASK;
-        else if (mask & FILE_D)
-            file_rank |= TO_FILE_D_MOVE_MASK;
-        else if (mask & FILE_E)
-            file_rank |= TO_FILE_E_MOVE_MASK;
-        else if (mask & FILE_F)
-            file_rank |= TO_FILE_F_MOVE_MASK;
-        else if (mask & FILE_G)
-            file_rank |= TO_FILE_G_MOVE_MASK;
-        else // if (mask & FILE_H)
-            file_rank |= TO_FILE_H_MOVE_MASK;
-        
-        // Determine rank
-        if (mask & RANK_1)
-            file_rank |= TO_RANK_1_MOVE_MASK;
-        else if (mask & RANK_2)
-            file_rank |= TO_RANK_2_MOVE_MASK;
-        else if (mask & RANK_3)
-            file_rank |= TO_RANK_3_MOVE_MASK;
-        else if (mask & RANK_4)
-            file_rank |= TO_RANK_4_MOVE_MASK;
-        else if (mask & RANK_5)
-            file_rank |= TO_RANK_5_MOVE_MASK;
-        else if (mask & RANK_6)
-            file_rank |= TO_RANK_6_MOVE_MASK;
-        else if (mask & RANK_7)
-            file_rank |= TO_RANK_7_MOVE_MASK;
-        else // if (mask & RANK_8)
-            file_rank |= TO_RANK_8_MOVE_MASK;
-
-        file_rank_to_piece[mask] = file_rank;
-    }
-
-    return file_rank_to_piece;   
+constexpr U64 knight_moves(int square) {
+    return step(square, 1, 2) | step(square, 1, -2) | step(square, -1, 2) | step(square, -1, -2) |
+           step(square, 2, 1) | step(square, 2, -1) | step(square, -2, 1) | step(square, -2, -1);
 }
 
-std::unordered_map<U64, int> PIECE_TO_FILE_RANK_MOVE_MASK__TO = get_piece_to_file_rank_move_mask__to();
-
-std::unordered_map<int, U64> get_file_rank_move_mask_to_piece__from(void) {
-    U64 from;
-    int move;
-    std::unordered_map<int, U64> file_rank_to_piece;
-    
-    for (int file = FROM_FILE_A_MOVE_MASK; file <= FROM_FILE_H_MOVE_MASK; file+=0x10) {
-        for (int rank = FROM_RANK_1_MOVE_MASK; rank <= FROM_RANK_8_MOVE_MASK; rank+=0x100) {
-            move = file | rank;
-            from = 0;
-            
-            if ((move & FROM_FILE_MOVE_MASK) == FROM_FILE_A_MOVE_MASK)
-                from |= FILE_A;
-            else if ((move & FROM_FILE_MOVE_MASK) == FROM_FILE_B_MOVE_MASK)
-                from |= FILE_B;
-            else if ((move & FROM_FILE_MOVE_MASK) == FROM_FILE_C_MOVE_MASK)
-                from |= FILE_C;
-            else if ((move & FROM_FILE_MOVE_MASK) == FROM_FILE_D_MOVE_MASK)
-                from |= FILE_D;
-            else if ((move & FROM_FILE_MOVE_MASK) == FROM_FILE_E_MOVE_MASK)
-                from |= FILE_E;
-            else if ((move & FROM_FILE_MOVE_MASK) == FROM_FILE_F_MOVE_MASK)
-                from |= FILE_F;
-            else if ((move & FROM_FILE_MOVE_MASK) == FROM_FILE_G_MOVE_MASK)
-                from |= FILE_G;
-            else // if ((move & FROM_FILE_MOVE_MASK) == FROM_FILE_H_MOVE_MASK)
-                from |= FILE_H;
-                
-            if ((move & FROM_RANK_MOVE_MASK) == FROM_RANK_1_MOVE_MASK)
-                from &= RANK_1;
-            else if ((move & FROM_RANK_MOVE_MASK) == FROM_RANK_2_MOVE_MASK)
-                from &= RANK_2;
-            else if ((move & FROM_RANK_MOVE_MASK) == FROM_RANK_3_MOVE_MASK)
-                from &= RANK_3;
-            else if ((move & FROM_RANK_MOVE_MASK) == FROM_RANK_4_MOVE_MASK)
-                from &= RANK_4;
-            else if ((move & FROM_RANK_MOVE_MASK) == FROM_RANK_5_MOVE_MASK)
-                from &= RANK_5;
-            else if ((move & FROM_RANK_MOVE_MASK) == FROM_RANK_6_MOVE_MASK)
-                from &= RANK_6;
-            else if ((move & FROM_RANK_MOVE_MASK) == FROM_RANK_7_MOVE_MASK)
-                from &= RANK_7;
-            else // if ((move & FROM_RANK_MOVE_MASK) == FROM_RANK_8_MOVE_MASK)
-                from &= RANK_8;
-            
-            file_rank_to_piece[move] = from;
-        }
-    }
-    
-    return file_rank_to_piece;
+constexpr U64 king_moves(int square) {
+    return step(square, 1, 0) | step(square, -1, 0) | step(square, 0, 1) | step(square, 0, -1) |
+           step(square, 1, 1) | step(square, 1, -1) | step(square, -1, 1) | step(square, -1, -1);
 }
-    
-std::unordered_map<int, U64> FILE_RANK_MOVE_MASK_TO_PIECE__FROM = get_file_rank_move_mask_to_piece__from();
 
-std::unordered_map<int, U64> get_file_rank_move_mask_to_piece__to(void) {
-    U64 to;
-    int move;
-    std::unordered_map<int, U64> file_rank_to_piece;
-    
-    for (int file = TO_FILE_A_MOVE_MASK; file <= TO_FILE_H_MOVE_MASK; file+=0x1000) {
-        for (int rank = TO_RANK_1_MOVE_MASK; rank <= TO_RANK_8_MOVE_MASK; rank+=0x10000) {
-            move = file | rank;
-            to = 0;
-
-            if ((move & TO_FILE_MOVE_MASK) == TO_FILE_A_MOVE_MASK)
-                to |= FILE_A;
-            else if ((move & TO_FILE_MOVE_MASK) == TO_FILE_B_MOVE_MASK) 
-                to |= FILE_B;
-            else if ((move & TO_FILE_MOVE_MASK) == TO_FILE_C_MOVE_MASK)
-                to |= FILE_C;
-            else if ((move & TO_FILE_MOVE_MASK) == TO_FILE_D_MOVE_MASK)
-                to |= FILE_D;
-            else if ((move & TO_FILE_MOVE_MASK) == TO_FILE_E_MOVE_MASK)
-                to |= FILE_E;
-            else if ((move & TO_FILE_MOVE_MASK) == TO_FILE_F_MOVE_MASK)
-                to |= FILE_F;
-            else if ((move & TO_FILE_MOVE_MASK) == TO_FILE_G_MOVE_MASK)
-                to |= FILE_G;
-            else // if ((move & TO_FILE_MOVE_MASK) == TO_FILE_H_MOVE_MASK)
-                to |= FILE_H;
-                
-            if ((move & TO_RANK_MOVE_MASK) == TO_RANK_1_MOVE_MASK)
-                to &= RANK_1;
-            else if ((move & TO_RANK_MOVE_MASK) == TO_RANK_2_MOVE_MASK)
-                to &= RANK_2;
-            else if ((move & TO_RANK_MOVE_MASK) == TO_RANK_3_MOVE_MASK)
-                to &= RANK_3;
-            else if ((move & TO_RANK_MOVE_MASK) == TO_RANK_4_MOVE_MASK)
-                to &= RANK_4;
-            else if ((move & TO_RANK_MOVE_MASK) == TO_RANK_5_MOVE_MASK)
-                to &= RANK_5;
-            else if ((move & TO_RANK_MOVE_MASK) == TO_RANK_6_MOVE_MASK)
-                to &= RANK_6;
-            else if ((move & TO_RANK_MOVE_MASK) == TO_RANK_7_MOVE_MASK)
-                to &= RANK_7;
-            else // if ((move & TO_RANK_MOVE_MASK) == TO_RANK_8_MOVE_MASK)
-                to &= RANK_8;
-                
-            file_rank_to_piece[move] = to;
-        }
-    }
-    
-    return file_rank_to_piece;
+constexpr U64 pawn_attacks(bool color, int square) {
+    return (color == WHITE) ? step(square, -1, -1) | step(square, -1, 1) : step(square, 1, -1) | step(square, 1, 1);
 }
 
-std::unordered_map<int, U64> FILE_RANK_MOVE_MASK_TO_PIECE__TO = get_file_rank_move_mask_to_piece__to();
-
-// Generate ray list map
-std::unordered_map<U64, std::vector<U64>> gen_rays_list(void) {
-    std::unordered_map<U64, std::vector<U64>> rays_list;
-    U64 mask;
-
-    for (int bit_index = 0; bit_index < BITBOARD_SIZE; bit_index++) {
-        mask = shift_left(1, bit_index);        
-        rays_list[mask] = std::vector<U64>();
-
-        rays_list[mask].push_back(n_ray(mask));
-        rays_list[mask].push_back(s_ray(mask));
-        rays_list[mask].push_back(e_ray(mask));
-        rays_list[mask].push_back(w_ray(mask));
-        rays_list[mask].push_back(ne_ray(mask));
-        rays_list[mask].push_back(nw_ray(mask));
-        rays_list[mask].push_back(se_ray(mask));
-        rays_list[mask].push_back(sw_ray(mask));
-    }
-    
-    return rays_list;
+constexpr int sign(int value) {
+    return (value > 0) - (value < 0);
 }
 
-std::unordered_map<U64, std::vector<U64>> RAYS_LIST = gen_rays_list();
-
-// Returns a map of piece to all rays emanating from that piece
-std::unordered_map<U64, U64> gen_rays(void) {
-    std::unordered_map<U64, U64> rays;
-    U64 mask;
-    
-    for (int bit_index = 0; bit_index < BITBOARD_SIZE; bit_index++) {
-        mask = shift_left(1, bit_index);
-        rays[mask] = 0;
-        
-        rays[mask] |= n_ray(mask);
-        rays[mask] |= s_ray(mask);
-        rays[mask] |= e_ray(mask);
-        rays[mask] |= w_ray(mask);
-        rays[mask] |= ne_ray(mask);
-        rays[mask] |= nw_ray(mask);
-        rays[mask] |= se_ray(mask);
-        rays[mask] |= sw_ray(mask);
-    }
-    
-    return rays;
+// Returns true if two different squares share a rank, file or diagonal
+constexpr bool aligned(int a, int b) {
+    return a != b && (a / 8 == b / 8 || a % 8 == b % 8 ||
+                      a / 8 - b / 8 == a % 8 - b % 8 || a / 8 - b / 8 == b % 8 - a % 8);
 }
 
-std::unordered_map<U64, U64> RAYS = gen_rays();
-
-std::unordered_map<U64, U64> gen_diag_rays(void) {
-    std::unordered_map<U64, U64> rays;
-    U64 mask;
-
-    for (int bit_index = 0; bit_index < BITBOARD_SIZE; bit_index++) {
-        mask = shift_left(1, bit_index);        
-        rays[mask] = 0;
-
-        rays[mask] |= ne_ray(mask);
-        rays[mask] |= nw_ray(mask);
-        rays[mask] |= se_ray(mask);
-        rays[mask] |= sw_ray(mask);
-    }
-    
-    return rays;
+constexpr U64 between(int a, int b) {
+    return aligned(a, b) ? ray(a, sign(b / 8 - a / 8), sign(b % 8 - a % 8)) & ray(b, sign(a / 8 - b / 8), sign(a % 8 - b % 8)) : 0;
 }
 
-std::unordered_map<U64, U64> DIAG_RAYS = gen_diag_rays();
+constexpr U64 line(int a, int b) {
+    return aligned(a, b) ? ray(a, sign(b / 8 - a / 8), sign(b % 8 - a % 8)) | ray(a, sign(a / 8 - b / 8), sign(a % 8 - b % 8)) | (U64)1 << a : 0;
+}
 
-std::set<U64> gen_rays_set(void) {
-    std::set<U64> rays;
-    U64 mask;
+// Files are encoded 1 (file A) to 8 (file H) and ranks 1 (rank 1) to 8 (rank 8)
+constexpr int file_rank_move_mask(int square) {
+    return (square % 8 + 1) | ((8 - square / 8) << 4);
+}
 
-    for (int bit_index = 0; bit_index < BITBOARD_SIZE; bit_index++) {
-        mask = shift_left(1, bit_index);        
-        
-        rays.insert(n_ray(mask) | s_ray(mask) | mask);
-        rays.insert(e_ray(mask) | w_ray(mask) | mask);
-        rays.insert(ne_ray(mask) | sw_ray(mask) | mask);
-        rays.insert(nw_ray(mask) | se_ray(mask) | mask);
-    }
-    
-    return rays;
+// Inverse of file_rank_move_mask, 0 for encodings that don't name a square
+constexpr U64 file_rank_move_mask_to_piece(int file_rank) {
+    return ((file_rank & 0xF) >= 1 && (file_rank & 0xF) <= 8 && (file_rank >> 4) >= 1 && (file_rank >> 4) <= 8) ?
+           (U64)1 << ((8 - (file_rank >> 4)) * 8 + (file_rank & 0xF) - 1) : 0;
 }
 
-std::set<U64> RAYS_SET = gen_rays_set();
+template <int... Squares>
+constexpr SquareTable gen_diag_rays(SquareSequence<Squares...>) {
+    return {{diag_rays(Squares)...}};
+}
 
-// hv: horizontal/vertical
-std::set<U64> gen_hv_rays_set(void) {
-    std::set<U64> rays;
-    U64 mask;
+template <int... Squares>
+constexpr SquareTable gen_knight_moves(SquareSequence<Squares...>) {
+    return {{knight_moves(Squares)...}};
+}
 
-    for (int bit_index = 0; bit_index < BITBOARD_SIZE; bit_index++) {
-        mask = shift_left(1, bit_index);        
-        
-        rays.insert(n_ray(mask) | s_ray(mask) | mask);
-        rays.insert(e_ray(mask) | w_ray(mask) | mask);
-    }
-    
-    return rays;
+template <int... Squares>
+constexpr SquareTable gen_king_moves(SquareSequence<Squares...>) {
+    return {{king_moves(Squares)...}};
 }
 
-std::set<U64> HV_RAYS_SET = gen_hv_rays_set();
+template <int... Squares>
+constexpr SquareTable gen_pawn_attacks(bool color, SquareSequence<Squares...>) {
+    return {{pawn_attacks(color, Squares)...}};
+}
 
-std::set<U64> gen_diag_rays_set(void) {
-    std::set<U64> rays;
-    U64 mask;
+template <int From, int... Squares>
+constexpr SquareTable gen_between_from(SquareSequence<Squares...>) {
+    return {{between(From, Squares)...}};
+}
 
-    for (int bit_index = 0; bit_index < BITBOARD_SIZE; bit_index++) {
-        mask = shift_left(1, bit_index);        
-        
-        rays.insert(ne_ray(mask) | sw_ray(mask) | mask);
-        rays.insert(nw_ray(mask) | se_ray(mask) | mask);
-    }
-    
-    return rays;
+template <int... Squares>
+constexpr std::array<SquareTable, BITBOARD_SIZE> gen_between(SquareSequence<Squares...>) {
+    return {{gen_between_from<Squares>(AllSquares())...}};
 }
 
-std::set<U64> DIAG_RAYS_SET = gen_diag_rays_set();
+template <int From, int... Squares>
+constexpr SquareTable gen_line_from(SquareSequence<Squares...>) {
+    return {{line(From, Squares)...}};
+}
 
-std::unordered_map<U64, U64> gen_knight_moves(void) {
-    std::unordered_map<U64, U64> knight_moves;
-    U64 mask;
-    
-    for (int bit_index = 0; bit_index < BITBOARD_SIZE; bit_index++) {
-        mask = shift_left(1, bit_index);
-        knight_moves[mask] = 0;
-
-        knight_moves[mask] |= shift_left(mask, 6);
-        knight_moves[mask] |= shift_left(mask, 10);
-        knight_moves[mask] |= shift_left(mask, 15);
-        knight_moves[mask] |= shift_left(mask, 17);
-        knight_moves[mask] |= shift_right(mask, 6);
-        knight_moves[mask] |= shift_right(mask, 10);
-        knight_moves[mask] |= shift_right(mask, 15);
-        knight_moves[mask] |= shift_right(mask, 17);
-
-        // Clean up moves if necessary
-        if (mask & (FILE_G | FILE_H)) {
-            knight_moves[mask] &= 0xF0F0F0F0F0F0F0F0;
-        }
-        else if (mask & (FILE_A | FILE_B)) {
-            knight_moves[mask] &= 0x0F0F0F0F0F0F0F0F;
-        }
-    }
+template <int... Squares>
+constexpr std::array<SquareTable, BITBOARD_SIZE> gen_line(SquareSequence<Squares...>) {
+    return {{gen_line_from<Squares>(AllSquares())...}};
+}
 
-    return knight_moves;;
+template <int... Squares>
+constexpr std::array<int, BITBOARD_SIZE> gen_piece_to_file_rank_move_mask(int shift, SquareSequence<Squares...>) {
+    return {{(file_rank_move_mask(Squares) << shift)...}};
 }
 
-std::unordered_map<U64, U64> KNIGHT_MOVES = gen_knight_moves();
+template <int... FileRanks>
+constexpr std::array<U64, NUM_FILE_RANK_MOVE_MASKS> gen_file_rank_move_mask_to_piece(SquareSequence<FileRanks...>) {
+    return {{file_rank_move_mask_to_piece(FileRanks)...}};
+}
 
-std::unordered_map<U64, U64> gen_king_moves(void) {
-    std::unordered_map<U64, U64> king_moves;
-    U64 mask;
-    
-    for (int bit_index = 0; bit_index < BITBOARD_SIZE; bit_index++) {
-        mask = shift_left(1, bit_index);
-        king_moves[mask] = 0;
-
-        king_moves[mask] |= shift_left(mask, 1);
-        king_moves[mask] |= shift_right(mask, 1);
-        king_moves[mask] |= shift_left(mask, 7);
-        king_moves[mask] |= shift_right(mask, 7);
-        king_moves[mask] |= shift_left(mask, 8);
-        king_moves[mask] |= shift_right(mask, 8);
-        king_moves[mask] |= shift_left(mask, 9);
-        king_moves[mask] |= shift_right(mask, 9);
-        
-        // Clean up moves if necessary
-        if (mask & FILE_A) {
-            king_moves[mask] &= FILE_A | FILE_B;
-        }
-        else if (mask & FILE_H) {
-            king_moves[mask] &= FILE_G | FILE_H;
-        }
-    }
+constexpr SquareTable DIAG_RAYS = gen_diag_rays(AllSquares());
+constexpr SquareTable KNIGHT_MOVES = gen_knight_moves(AllSquares());
+constexpr SquareTable KING_MOVES = gen_king_moves(AllSquares());
+constexpr std::array<SquareTable, NUM_COLORS> PAWN_ATTACKS = {{gen_pawn_attacks(WHITE, AllSquares()), gen_pawn_attacks(BLACK, AllSquares())}};
+constexpr std::array<SquareTable, BITBOARD_SIZE> BETWEEN = gen_between(AllSquares());
+constexpr std::array<SquareTable, BITBOARD_SIZE> LINE = gen_line(AllSquares());
 
-    return king_moves;
-}
+constexpr std::array<int, BITBOARD_SIZE> PIECE_TO_FILE_RANK_MOVE_MASK__FROM = gen_piece_to_file_rank_move_mask(FROM_MOVE_SHIFT, AllSquares());
+constexpr std::array<int, BITBOARD_SIZE> PIECE_TO_FILE_RANK_MOVE_MASK__TO = gen_piece_to_file_rank_move_mask(TO_MOVE_SHIFT, AllSquares());
 
-std::unordered_map<U64, U64> KING_MOVES = gen_king_moves();
+constexpr std::array<U64, NUM_FILE_RANK_MOVE_MASKS> FILE_RANK_MOVE_MASK_TO_PIECE__FROM = gen_file_rank_move_mask_to_piece(MakeSquareSequence<NUM_FILE_RANK_MOVE_MASKS>::type());
+constexpr std::array<U64, NUM_FILE_RANK_MOVE_MASKS> FILE_RANK_MOVE_MASK_TO_PIECE__TO = FILE_RANK_MOVE_MASK_TO_PIECE__FROM;
 
 std::string get_move_str(int move) {
     // Check castling    
@@ -799,14 +404,11 @@ std::string get_move_str(int move) {
 }
 
 int count_set_bits(U64 bits) {
-    int count = 0;
-
-    while (bits) {
-        count += bits & 1;
-        bits >>= 1;
-    }
-
-    return count;
+#ifdef _MSC_VER
+    return (int)__popcnt64(bits);
+#else
+    return __builtin_popcountll(bits);
+#endif
 }
 
 // Returns the file & rank integer encoding for the given SAN, with the file starting at starting_index
@@ -936,37 +538,3 @@ int server_san_to_move(std::string san) {
 
     return move | get_to_file_rank_mask(san, length - 2);
 }
-
-// Returns the actions sorted by history table value
-// There is room for efficiency improvements here
-std::vector<int> ht_sort(std::vector<int> actions, std::unordered_map<int, int> history_table) {
-    std::vector<int> sorted;
-    std::unordered_map<int, int> ht_entries;
-    bool inserted;
-
-    // Read off history table entries
-    for (auto &action : actions) {
-        if (ht_contains(history_table, action))
-            ht_entries[action] = history_table[action];
-        else
-            ht_entries[action] = 0;
-    }
-
-    // Sort the actions
-    for (auto &action : actions) {
-        inserted = false;
-
-        for(std::vector<int>::iterator it = sorted.begin(); it != sorted.end(); it++)    {
-            if (ht_entries[action] > ht_entries[*it]) {
-                sorted.insert(it, action);
-                inserted = true;
-                break;
-            }
-        }
-
-        if (!inserted)
-            sorted.push_back(action);
-    }
-
-    return sorted;
-}
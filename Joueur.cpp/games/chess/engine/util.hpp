@@ -2,14 +2,37 @@
 #define UTIL_HPP
 
 #include "constants.hpp"
+#include "movelist.hpp"
+#include <array>
 #include <chrono>
 #include <iostream>
-#include <set>
 #include <sstream>
-#include <unordered_map>
 #include <vector>
 
-#define GET_TIME_NS() ((double)(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count()))
+// Monotonic, so deadlines can't move when the wall clock is adjusted
+#define GET_TIME_NS() ((double)(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count()))
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Returns the index of the lowest set bit of a (non-empty) bitboard
+inline int get_square(U64 bitboard) {
+#ifdef _MSC_VER
+    unsigned long square;
+    _BitScanForward64(&square, bitboard);
+    return (int)square;
+#else
+    return __builtin_ctzll(bitboard);
+#endif
+}
+
+// Removes the lowest set bit from bitboard and returns it
+inline U64 pop_lsb(U64 &bitboard) {
+    U64 lsb = bitboard & (0 - bitboard);
+    bitboard &= bitboard - 1;
+    return lsb;
+}
 
 U64 shift_left(U64 value, int shift_amount);
 U64 shift_right(U64 value, int shift_amount);
@@ -26,50 +49,79 @@ void print(std::string thing_to_print);
 void print(void);
 void pretty_print(U64 bitboard);
 bool str_contains(std::string str1, char str2);
-bool map_contains(std::unordered_map<U64, U64> map, U64 item);
-bool set_contains(std::set<U64> set, U64 item);
-bool ht_contains(std::unordered_map<int, int> ht, int move);
-std::vector<U64> split_bitboard(U64 bitboard);
 
-std::unordered_map<std::string, U64> get_file_rank_to_piece_str(void);
-extern std::unordered_map<std::string, U64> FILE_RANK_TO_PIECE;
+int file_rank_to_square(std::string file_rank);
 
-std::unordered_map<U64, std::string> get_piece_to_file_rank(void);
-extern std::unordered_map<U64, std::string> PIECE_TO_FILE_RANK;
+// Compile-time sequence of square indices (std::index_sequence is C++14)
+template <int... Squares>
+struct SquareSequence {};
 
-std::unordered_map<U64, int> get_piece_to_file_rank_move_mask__from(void);
-std::unordered_map<U64, int> get_piece_to_file_rank_move_mask__to(void);
-extern std::unordered_map<U64, int> PIECE_TO_FILE_RANK_MOVE_MASK__FROM;
-extern std::unordered_map<U64, int> PIECE_TO_FILE_RANK_MOVE_MASK__TO;
+template <int N, int... Squares>
+struct MakeSquareSequence : MakeSquareSequence<N - 1, N - 1, Squares...> {};
 
-std::unordered_map<int, U64> get_file_rank_move_mask_to_piece__from(void);
-std::unordered_map<int, U64> get_file_rank_move_mask_to_piece__to(void);
-extern std::unordered_map<int, U64> FILE_RANK_MOVE_MASK_TO_PIECE__FROM;
-extern std::unordered_map<int, U64> FILE_RANK_MOVE_MASK_TO_PIECE__TO;
+template <int... Squares>
+struct MakeSquareSequence<0, Squares...> {
+    typedef SquareSequence<Squares...> type;
+};
 
-std::unordered_map<U64, std::vector<U64>> gen_rays_list(void);
-extern std::unordered_map<U64, std::vector<U64>> RAYS_LIST;
+typedef MakeSquareSequence<BITBOARD_SIZE>::type AllSquares;
 
-std::unordered_map<U64, U64> gen_rays(void);
-extern std::unordered_map<U64, U64> RAYS;
+// A bitboard per square, indexed with get_square()
+typedef std::array<U64, BITBOARD_SIZE> SquareTable;
 
-std::unordered_map<U64, U64> gen_diag_rays(void);
-extern std::unordered_map<U64, U64> DIAG_RAYS;
+// Indexed by the square of the moving piece
+extern const std::array<int, BITBOARD_SIZE> PIECE_TO_FILE_RANK_MOVE_MASK__FROM;
+extern const std::array<int, BITBOARD_SIZE> PIECE_TO_FILE_RANK_MOVE_MASK__TO;
 
-std::set<U64> gen_rays_set(void);
-extern std::set<U64> RAYS_SET;
+// Indexed by (move & FROM_FILE_RANK_MOVE_MASK) >> FROM_MOVE_SHIFT and
+// (move & TO_FILE_RANK_MOVE_MASK) >> TO_MOVE_SHIFT respectively
+extern const std::array<U64, NUM_FILE_RANK_MOVE_MASKS> FILE_RANK_MOVE_MASK_TO_PIECE__FROM;
+extern const std::array<U64, NUM_FILE_RANK_MOVE_MASKS> FILE_RANK_MOVE_MASK_TO_PIECE__TO;
 
-std::set<U64> gen_hv_rays_set(void);
-extern std::set<U64> HV_RAYS_SET;
+// Returns the square move's piece moves from, the king's square for color's castling moves
+inline int get_from_square(int move, bool color) {
+    if (move & CASTLE_MOVE_MASK)
+        return get_square((color == WHITE) ? WHITE_KING_START : BLACK_KING_START);
 
-std::set<U64> gen_diag_rays_set(void);
-extern std::set<U64> DIAG_RAYS_SET;
+    return get_square(FILE_RANK_MOVE_MASK_TO_PIECE__FROM[(move & FROM_FILE_RANK_MOVE_MASK) >> FROM_MOVE_SHIFT]);
+}
 
-std::unordered_map<U64, U64> gen_knight_moves(void);
-extern std::unordered_map<U64, U64> KNIGHT_MOVES;
+// Returns the square move's piece moves to, the king's square for color's castling moves
+inline int get_to_square(int move, bool color) {
+    if ((move & CASTLE_MOVE_MASK) == KINGSIDE_CASTLE_MOVE_MASK)
+        return get_square((color == WHITE) ? WHITE_CASTLE_KINGSIDE_KING_MOVE : BLACK_CASTLE_KINGSIDE_KING_MOVE);
 
-std::unordered_map<U64, U64> gen_king_moves(void);
-extern std::unordered_map<U64, U64> KING_MOVES;
+    if ((move & CASTLE_MOVE_MASK) == QUEENSIDE_CASTLE_MOVE_MASK)
+        return get_square((color == WHITE) ? WHITE_CASTLE_QUEENSIDE_KING_MOVE : BLACK_CASTLE_QUEENSIDE_KING_MOVE);
+
+    return get_square(FILE_RANK_MOVE_MASK_TO_PIECE__TO[(move & TO_FILE_RANK_MOVE_MASK) >> TO_MOVE_SHIFT]);
+}
+
+// Returns the type of move's piece, 0 through NUM_PIECE_TYPES - 1
+inline int get_piece_index(int move) {
+    if (move & CASTLE_MOVE_MASK)
+        return KING_MOVE_MASK - 1;
+
+    return (move & PIECE_MOVE_MASK) - 1;
+}
+
+// Returns true if move neither captures nor promotes
+inline bool is_quiet(int move) {
+    return !(move & (ATTACK_MOVE_MASK | PROMO_MOVE_MASK));
+}
+
+extern const SquareTable DIAG_RAYS;
+
+extern const SquareTable KNIGHT_MOVES;
+extern const SquareTable KING_MOVES;
+
+// Squares a pawn of the indexing color attacks from each square
+extern const std::array<SquareTable, NUM_COLORS> PAWN_ATTACKS;
+
+// Indexed by two squares: the squares strictly between them and the full line through
+// them when they share a rank, file or diagonal, 0 otherwise
+extern const std::array<SquareTable, BITBOARD_SIZE> BETWEEN;
+extern const std::array<SquareTable, BITBOARD_SIZE> LINE;
 
 std::string get_move_str(int move);
 int count_set_bits(U64 bits);
@@ -77,6 +129,4 @@ int count_set_bits(U64 bits);
 int get_to_file_rank_mask(std::string san, int starting_index);
 int server_san_to_move(std::string san);
 
-std::vector<int> ht_sort(std::vector<int> actions, std::unordered_map<int, int> history_table);
-
 #endif // UTIL_HPP
@@ -0,0 +1,81 @@
+#ifndef WORKDEQUE_HPP
+#define WORKDEQUE_HPP
+
+#include "constants.hpp"
+#include <atomic>
+#include <cstdint>
+
+// Fixed-capacity Chase-Lev work stealing deque of pointers
+//
+// The owning thread pushes and pops at the bottom (LIFO) while any other thread
+// may steal from the top (FIFO). Follows Le et al., "Correct and Efficient
+// Work-Stealing for Weak Memory Models" (PPoPP 2013) minus resizing, with the
+// fences folded into the accesses next to them.
+template <typename T, int Size = WORK_DEQUE_SIZE>
+class WorkDeque {
+private:
+    static_assert((Size & (Size - 1)) == 0, "WorkDeque size must be a power of 2");
+
+    std::atomic<int64_t> top;
+    std::atomic<int64_t> bottom;
+    std::atomic<T *> items[Size];
+
+public:
+    WorkDeque() : top(0), bottom(0) {}
+
+    // Owner only. Returns false if the deque is full
+    bool push(T *item) {
+        int64_t b = this->bottom.load(std::memory_order_relaxed);
+        int64_t t = this->top.load(std::memory_order_acquire);
+
+        if (b - t >= Size)
+            return false;
+
+        this->items[b & (Size - 1)].store(item, std::memory_order_relaxed);
+        this->bottom.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Owner only. Returns the newest item, NULL if the deque is empty
+    T *pop(void) {
+        int64_t b = this->bottom.load(std::memory_order_relaxed) - 1;
+        this->bottom.store(b, std::memory_order_seq_cst);
+        int64_t t = this->top.load(std::memory_order_seq_cst);
+
+        if (t > b) {
+            // Empty
+            this->bottom.store(b + 1, std::memory_order_relaxed);
+            return NULL;
+        }
+
+        T *item = this->items[b & (Size - 1)].load(std::memory_order_relaxed);
+
+        if (t == b) {
+            // Last item, race the thieves for it
+            if (!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                item = NULL;
+
+            this->bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        return item;
+    }
+
+    // Any thread. Returns the oldest item, NULL if the deque is empty or another thread got it first
+    T *steal(void) {
+        int64_t t = this->top.load(std::memory_order_seq_cst);
+        int64_t b = this->bottom.load(std::memory_order_seq_cst);
+
+        if (t >= b)
+            return NULL;
+
+        T *item = this->items[t & (Size - 1)].load(std::memory_order_relaxed);
+
+        if (!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return NULL;
+
+        return item;
+    }
+};
+
+#endif // WORKDEQUE_HPP
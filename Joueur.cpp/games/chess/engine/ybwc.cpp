@@ -0,0 +1,281 @@
+#include "search.hpp"
+#include "transposition.hpp"
+#include "util.hpp"
+#include "ybwc.hpp"
+#include <thread>
+
+YBWCWorker::YBWCWorker(YBWCPool *pool, int id) {
+    this->pool = pool;
+    this->id = id;
+    this->level = -1;
+    this->split_points.reset(new SplitPoint[YBWC_MAX_SPLITS]);
+    this->num_splits = 0;
+    this->steals = 0;
+    this->idle_ns = 0;
+    this->random = 2463534242u + id;
+}
+
+// Searches task's move from its split point's position on this thread and reports back to the split point
+void YBWCWorker::run_task(Task *task) {
+    SplitPoint *sp = task->split;
+
+    // Take the split point's position into the next level's state
+    this->level++;
+    if (this->level == (int)this->states.size()) {
+        this->states.emplace_back(new State(*sp->state));
+        // Only what this thread searches counts, the owner's nodes are counted with it
+        this->states.back()->reset_stats();
+    }
+    else
+        this->states[this->level]->copy_position(*sp->state);
+
+    State &state = *this->states[this->level];
+    state.worker = this;
+    state.split = sp;
+    state.limits = sp->state->limits;
+
+    if (!cutoff_occurred(sp) && !search_stopped.load(std::memory_order_relaxed)) {
+        // Younger brothers are expected to fail low, prove it with a null window first
+        int alpha = sp->alpha.load(std::memory_order_relaxed);
+        int value = search_action(state, task->move, sp->depth, alpha, alpha + 1);
+
+        if (value > alpha && value < sp->beta)
+            value = search_action(state, task->move, sp->depth, alpha, sp->beta);
+
+        if (!cutoff_occurred(sp) && !search_stopped.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> guard(sp->lock);
+
+            if (value > sp->value) {
+                sp->value = value;
+                sp->best_action = task->move;
+            }
+
+            if (value > sp->alpha.load(std::memory_order_relaxed))
+                sp->alpha.store(value, std::memory_order_relaxed);
+
+            if (value >= sp->beta)
+                // Fail high, cancel the remaining brothers
+                sp->cutoff.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    this->level--;
+    sp->pending.fetch_sub(1, std::memory_order_release);
+}
+
+// Returns this thread's newest task, else one stolen from another thread, NULL if there are none
+Task *YBWCWorker::find_task(void) {
+    Task *task = this->deque.pop();
+    if (task)
+        return task;
+
+    // Start from a random victim so thieves spread out
+    this->random ^= this->random << 13;
+    this->random ^= this->random >> 17;
+    this->random ^= this->random << 5;
+
+    int num_workers = this->pool->workers.size();
+    int start = this->random % num_workers;
+
+    for (int i = 0; i < num_workers; i++) {
+        YBWCWorker *victim = this->pool->workers[(start + i) % num_workers].get();
+
+        if (victim == this)
+            continue;
+
+        task = victim->deque.steal();
+        if (task) {
+            this->steals++;
+            return task;
+        }
+    }
+
+    return NULL;
+}
+
+// Helper threads run tasks until the search is stopped
+void YBWCWorker::idle_loop(void) {
+    Task *task;
+    double idle_start = GET_TIME_NS();
+    this->pool->num_idle++;
+
+    while (!search_stopped.load(std::memory_order_relaxed)) {
+        task = this->find_task();
+
+        if (task) {
+            this->pool->num_idle--;
+            this->idle_ns += GET_TIME_NS() - idle_start;
+
+            this->run_task(task);
+
+            idle_start = GET_TIME_NS();
+            this->pool->num_idle++;
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+
+    this->idle_ns += GET_TIME_NS() - idle_start;
+    this->pool->num_idle--;
+}
+
+// Runs tasks (sp's own first) until every one of sp's tasks is finished
+void YBWCWorker::wait_for(SplitPoint *sp) {
+    Task *task;
+    double idle_start = 0;
+
+    while (sp->pending.load(std::memory_order_acquire) > 0) {
+        task = this->find_task();
+
+        if (task) {
+            if (idle_start) {
+                this->pool->num_idle--;
+                this->idle_ns += GET_TIME_NS() - idle_start;
+                idle_start = 0;
+            }
+
+            this->run_task(task);
+        }
+        else {
+            if (!idle_start) {
+                // Only thieves are left working on sp
+                this->pool->num_idle++;
+                idle_start = GET_TIME_NS();
+            }
+
+            std::this_thread::yield();
+        }
+    }
+
+    if (idle_start) {
+        this->pool->num_idle--;
+        this->idle_ns += GET_TIME_NS() - idle_start;
+    }
+}
+
+YBWCPool::YBWCPool(int num_threads) : num_idle(0) {
+    for (int i = 0; i < num_threads; i++)
+        this->workers.emplace_back(new YBWCWorker(this, i));
+}
+
+// Returns true if state's remaining moves at depth should be handed out to other threads
+bool ybwc_can_split(const State &state, int depth) {
+    return state.worker &&
+        depth >= YBWC_MIN_SPLIT_DEPTH &&
+        state.worker->num_splits < YBWC_MAX_SPLITS &&
+        state.worker->pool->num_idle.load(std::memory_order_relaxed) > 0;
+}
+
+// Searches the moves picker has left in parallel, once the eldest brother has been
+// searched without a cutoff. value & best_action hold the result so far and are
+// updated with the result of the remaining moves
+void ybwc_split(State &state, MovePicker &picker, int depth, int alpha, int beta, int &value, int &best_action) {
+    YBWCWorker *worker = state.worker;
+    SplitPoint &sp = worker->split_points[worker->num_splits++];
+    int num_tasks = 0;
+    int move;
+
+    // Every stage is generated now, there's no cutoff to stop picking early for
+    while ((move = picker.next_move())) {
+        Task &task = sp.tasks[num_tasks++];
+        task.split = &sp;
+        task.move = move;
+    }
+
+    if (!num_tasks) {
+        worker->num_splits--;
+        return;
+    }
+
+    sp.state = &state;
+    sp.parent = state.split;
+    sp.depth = depth;
+    sp.beta = beta;
+    sp.alpha.store(alpha, std::memory_order_relaxed);
+    sp.cutoff.store(false, std::memory_order_relaxed);
+    sp.value = value;
+    sp.best_action = best_action;
+    sp.pending.store(num_tasks, std::memory_order_release);
+
+    // Pushed last to first so this thread pops them in move order while thieves take the tail
+    for (int i = num_tasks - 1; i >= 0; i--) {
+        if (!worker->deque.push(&sp.tasks[i]))
+            worker->run_task(&sp.tasks[i]);
+    }
+
+    worker->wait_for(&sp);
+
+    value = sp.value;
+    best_action = sp.best_action;
+    worker->num_splits--;
+}
+
+// Young Brothers Wait: the main thread runs the usual iterative deepening, and every
+// node deep enough searches its first move alone before handing the rest to the pool
+// Returns the main thread's action
+int ybwc_search(const ChessBoard &board, bool max_player_color, const std::vector<U64> &key_history, const SearchLimits &limits, SearchStats *stats) {
+    int num_threads = std::max(1, limits.threads);
+
+    TT.new_search();
+
+    YBWCPool pool(num_threads);
+    YBWCWorker *main_worker = pool.workers[0].get();
+
+    main_worker->states.emplace_back(new State(board, max_player_color, key_history));
+    main_worker->level = 0;
+
+    State &root = *main_worker->states[0];
+    root.worker = main_worker;
+    root.limits = &limits;
+
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < num_threads; i++)
+        helpers.push_back(std::thread(&YBWCWorker::idle_loop, pool.workers[i].get()));
+
+    int action = iterative_deepening(root, 1, limits, true);
+
+    search_stopped = true;
+    for (auto &helper : helpers)
+        helper.join();
+
+    U64 nodes = 0;
+    U64 steals = 0;
+    U64 null_moves = 0;
+    U64 null_cutoffs = 0;
+    U64 tt_probes = 0;
+    U64 tt_hits = 0;
+    double idle_ns = 0;
+
+    for (auto &worker : pool.workers) {
+        for (auto &state : worker->states) {
+            nodes += state->nodes;
+            null_moves += state->null_moves;
+            null_cutoffs += state->null_cutoffs;
+            tt_probes += state->tt_probes;
+            tt_hits += state->tt_hits;
+        }
+
+        steals += worker->steals;
+        idle_ns += worker->idle_ns;
+    }
+
+    if (!limits.silent)
+        print("Nodes: " + std::to_string(nodes) + ", threads: " + std::to_string(num_threads) + ", steals: " + std::to_string(steals) +
+            ", idle: " + std::to_string(idle_ns / 1e9) + " s, TT hit rate: " + std::to_string(tt_probes ? 100.0 * tt_hits / tt_probes : 0) + "%" +
+            ", null move cutoffs: " + std::to_string(null_cutoffs) + "/" + std::to_string(null_moves));
+
+    if (stats) {
+        stats->nodes = nodes;
+        stats->depth = root.completed_depth;
+        stats->steals = steals;
+        stats->idle_ns = idle_ns;
+        stats->researches = root.researches;
+        stats->null_moves = null_moves;
+        stats->null_cutoffs = null_cutoffs;
+        stats->tt_probes = tt_probes;
+        stats->tt_hits = tt_hits;
+    }
+
+    return action;
+}
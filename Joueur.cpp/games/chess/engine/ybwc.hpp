@@ -0,0 +1,89 @@
+#ifndef YBWC_HPP
+#define YBWC_HPP
+
+#include "constants.hpp"
+#include "movepick.hpp"
+#include "search.hpp"
+#include "state.hpp"
+#include "workdeque.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct SplitPoint;
+class YBWCPool;
+
+// One of a split point's younger brothers
+struct Task {
+    SplitPoint *split;
+    int move;
+};
+
+// A node whose remaining moves are searched in parallel once its eldest move is done
+struct SplitPoint {
+    State *state;       // The owner's state, positioned at the node
+    SplitPoint *parent; // Split point the node itself is being searched under, NULL if none
+    int depth;
+    int beta;
+    std::atomic<int> alpha;
+    std::atomic<int> pending; // Tasks not yet finished
+    std::atomic<bool> cutoff; // Set once a task fails high, cancelling the rest
+
+    std::mutex lock; // Guards value & best_action
+    int value;
+    int best_action;
+
+    Task tasks[MAX_NUM_MOVES];
+};
+
+// Returns true if sp or any split point above it has been cut off
+inline bool cutoff_occurred(const SplitPoint *sp) {
+    for (; sp; sp = sp->parent) {
+        if (sp->cutoff.load(std::memory_order_relaxed))
+            return true;
+    }
+
+    return false;
+}
+
+// A search thread and everything it owns
+class YBWCWorker {
+public:
+    YBWCPool *pool;
+    int id;
+    WorkDeque<Task> deque;
+
+    // states[level] holds the position of the level'th task this thread is nested in
+    // (the main thread's root search is level 0), allocated the first time it's needed
+    std::vector<std::unique_ptr<State>> states;
+    int level;
+
+    std::unique_ptr<SplitPoint[]> split_points; // Used as a stack, splits nest
+    int num_splits;
+
+    U64 steals;
+    double idle_ns;
+    uint32_t random; // Victim selection
+
+    YBWCWorker(YBWCPool *pool, int id);
+    void run_task(Task *task);
+    Task *find_task(void);
+    void idle_loop(void);
+    void wait_for(SplitPoint *sp);
+};
+
+// Every thread of one YBWC search
+class YBWCPool {
+public:
+    std::vector<std::unique_ptr<YBWCWorker>> workers;
+    std::atomic<int> num_idle; // Threads looking for work
+
+    YBWCPool(int num_threads);
+};
+
+bool ybwc_can_split(const State &state, int depth);
+void ybwc_split(State &state, MovePicker &picker, int depth, int alpha, int beta, int &value, int &best_action);
+int ybwc_search(const ChessBoard &board, bool max_player_color, const std::vector<U64> &key_history, const SearchLimits &limits, SearchStats *stats=NULL);
+
+#endif // YBWC_HPP
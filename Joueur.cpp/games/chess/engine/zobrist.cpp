@@ -0,0 +1,48 @@
+#include "zobrist.hpp"
+
+// Keys are the splitmix64 sequence, generated at compile time so every build
+// (and every saved hash) agrees on them
+constexpr U64 ZOBRIST_SEED = 0x2545F4914F6CDD1D;
+constexpr U64 SPLITMIX_INCREMENT = 0x9E3779B97F4A7C15;
+
+constexpr U64 xorshift_multiply(U64 value, int shift, U64 multiplier) {
+    return (value ^ (value >> shift)) * multiplier;
+}
+
+constexpr U64 splitmix_finalize(U64 value) {
+    return value ^ (value >> 31);
+}
+
+// Returns the nth key of the sequence
+constexpr U64 zobrist_key(int n) {
+    return splitmix_finalize(xorshift_multiply(xorshift_multiply(ZOBRIST_SEED + (U64)(n + 1) * SPLITMIX_INCREMENT,
+                                                                 30, 0xBF58476D1CE4E5B9),
+                                               27, 0x94D049BB133111EB));
+}
+
+// Keys are numbered pieces first, then castling rights, en passant files and the side to move
+constexpr int ZOBRIST_CASTLING_FIRST = NUM_BITBOARDS * BITBOARD_SIZE;
+constexpr int ZOBRIST_EN_PASSANT_FIRST = ZOBRIST_CASTLING_FIRST + NUM_CASTLING_RIGHTS_STATES;
+constexpr int ZOBRIST_BLACK_TO_MOVE_INDEX = ZOBRIST_EN_PASSANT_FIRST + NUM_FILES;
+
+template <int... Squares>
+constexpr SquareTable gen_zobrist_piece(int bitboard_index, SquareSequence<Squares...>) {
+    return {{zobrist_key(bitboard_index * BITBOARD_SIZE + Squares)...}};
+}
+
+template <int... BitboardIndices>
+constexpr std::array<SquareTable, NUM_BITBOARDS> gen_zobrist_pieces(SquareSequence<BitboardIndices...>) {
+    return {{gen_zobrist_piece(BitboardIndices, AllSquares())...}};
+}
+
+template <int N, int... Indices>
+constexpr std::array<U64, N> gen_zobrist_keys(int first, SquareSequence<Indices...>) {
+    return {{zobrist_key(first + Indices)...}};
+}
+
+constexpr std::array<SquareTable, NUM_BITBOARDS> ZOBRIST_PIECES = gen_zobrist_pieces(MakeSquareSequence<NUM_BITBOARDS>::type());
+constexpr std::array<U64, NUM_CASTLING_RIGHTS_STATES> ZOBRIST_CASTLING =
+    gen_zobrist_keys<NUM_CASTLING_RIGHTS_STATES>(ZOBRIST_CASTLING_FIRST, MakeSquareSequence<NUM_CASTLING_RIGHTS_STATES>::type());
+constexpr std::array<U64, NUM_FILES> ZOBRIST_EN_PASSANT_FILE =
+    gen_zobrist_keys<NUM_FILES>(ZOBRIST_EN_PASSANT_FIRST, MakeSquareSequence<NUM_FILES>::type());
+constexpr U64 ZOBRIST_BLACK_TO_MOVE = zobrist_key(ZOBRIST_BLACK_TO_MOVE_INDEX);
@@ -0,0 +1,15 @@
+#ifndef ZOBRIST_HPP
+#define ZOBRIST_HPP
+
+#include "constants.hpp"
+#include "util.hpp"
+#include <array>
+
+// Random keys XORed together into a position's Zobrist key, one for each
+// piece on each square, the castling rights, the en passant file and black to move
+extern const std::array<SquareTable, NUM_BITBOARDS> ZOBRIST_PIECES;
+extern const std::array<U64, NUM_CASTLING_RIGHTS_STATES> ZOBRIST_CASTLING;
+extern const std::array<U64, NUM_FILES> ZOBRIST_EN_PASSANT_FILE;
+extern const U64 ZOBRIST_BLACK_TO_MOVE;
+
+#endif // ZOBRIST_HPP